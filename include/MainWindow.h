@@ -3,6 +3,7 @@
 
 #include <QMainWindow>
 #include <QVBoxLayout>
+#include <QStringList>
 
 // Forward declarations
 class TopBar;
@@ -23,6 +24,7 @@ private slots:
     void handleAssignTask();
     void handleDroneAnimationCompleted();
     void handleRightSidebarTaskAssignment(const QString& missionType, const QString& vehicle, const QString& prompt);
+    void handleImportShapes();
 
 private:
     void setupMainArea();
@@ -35,6 +37,9 @@ private:
     LeftSidebar* leftSidebar;
     RightSidebar* rightSidebar;
     MapViewer* mapViewer;
+
+    // Geofence and corridor advisories of the mission being received
+    QStringList missionAdvisories;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
@@ -4,12 +4,20 @@
 #include <QObject>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QNetworkRequest>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QString>
+#include <QStringList>
 #include <QDir>
 #include <QFile>
+#include <QHash>
+#include <QList>
+#include <QElapsedTimer>
+#include "LatencyHistogram.h"
+#include "../map/pathvalidator.h"
+#include "../map/corridorindex.h"
 
 class ChatGPTClient : public QObject
 {
@@ -18,27 +26,103 @@ public:
     static ChatGPTClient& instance();
     void sendPrompt(const QString& missionType, const QString& vehicle, const QString& prompt);
 
+    // Plans paths for several vehicles in one request and splits the reply per drone
+    void sendFleetPrompt(const QString& missionType, const QStringList& vehicles, const QString& prompt);
+
+    // Hedging (on by default) fires a duplicate request once the first one
+    // exceeds the backend p95
+    void setHedgingEnabled(bool enabled) { hedgingEnabled = enabled; }
+    bool isHedgingEnabled() const { return hedgingEnabled; }
+    void setMaxRetries(int retries) { maxRetries = qMax(0, retries); }
+
+    // Latency observed for a backend ("host/model"), used for timeouts and hedging
+    LatencyHistogram latencyHistogram(const QString& backend) const { return latencyHistograms.value(backend); }
+
 signals:
     void responseReceived(int missionId, const QString& response, const QString& functions);
     void errorOccurred(const QString& errorMessage);
+    // A planned path violates geofences; it is still stored, flagged in its properties
+    void pathViolationsFound(const QString& droneName, const QJsonArray& violations);
+    // A planned path's corridor overlaps the corridor of another drone
+    void corridorConflictsFound(const QString& droneName, const QJsonArray& conflicts);
 
 private slots:
     void handleNetworkReply(QNetworkReply* reply);
 
 private:
+    // One logical planner call, possibly spread over several attempts and hedged replies
+    struct PendingRequest {
+        int missionId = -1;
+        QStringList vehicles;
+        bool fleet = false;
+        QString backend;
+        QNetworkRequest request;
+        QByteArray body;
+        int attempt = 0;
+        qint64 attemptStartTime = 0;
+        int timeoutMs = 0;
+        bool hedged = false;
+        QList<QNetworkReply*> replies;
+    };
+
     explicit ChatGPTClient(QObject* parent = nullptr);
     ~ChatGPTClient();
-    
+
     // Prevent copying
     ChatGPTClient(const ChatGPTClient&) = delete;
     ChatGPTClient& operator=(const ChatGPTClient&) = delete;
-    
+
     // Helper method to load geometric shapes data
     QJsonObject loadGeometricShapesData();
-    
+
+    // Prompt construction
+    void dispatchPrompt(const QString& missionType, const QStringList& vehicles,
+                        const QString& prompt, bool fleet);
+    static QString singlePathInstructions();
+    static QString fleetPathInstructions();
+
+    // Request lifecycle
+    void startAttempt(int requestId);
+    QNetworkReply* postReply(int requestId);
+    void handleAttemptTimeout(int requestId, int attempt);
+    void fireHedge(int requestId, int attempt);
+    void retryOrFail(int requestId, const QString& reason);
+    void abortReplies(PendingRequest& pending);
+    bool isTransientError(QNetworkReply* reply) const;
+    int attemptTimeoutMs(const QString& backend) const;
+    int hedgeDelayMs(const QString& backend) const;
+
+    // Handles a successful API response for a mission
+    bool extractContent(const QByteArray& responseData, QString& content);
+    void processResponse(int missionId, const QByteArray& responseData);
+    void processFleetResponse(int missionId, const QStringList& vehicles, const QByteArray& responseData);
+    static bool isValidPathFeature(const QJsonObject& feature);
+    int updateMissionDetails(int missionId, const QString& missionTitle, QString& vehicleName);
+    void storeDronePath(const QString& vehicleName, QJsonObject feature);
+
+    // Geofence check of planned paths against the current shapes
+    QMap<QString, PathValidationResult> validatePaths(const QMap<QString, QJsonObject>& paths);
+    void applyValidation(QJsonObject& feature, const PathValidationResult& validation);
+
+    // Deconfliction of planned corridors against every other drone's path
+    QMap<QString, QVector<CorridorConflict>> checkCorridors(const QMap<QString, QJsonObject>& paths);
+    void applyCorridorConflicts(QJsonObject& feature, const QString& droneName,
+                                const QVector<CorridorConflict>& conflicts);
+
     QNetworkAccessManager* networkManager;
     QString apiKey;
-    int currentMissionId;
+
+    QHash<int, PendingRequest> pendingRequests;
+    QHash<QNetworkReply*, int> replyRequests;
+    QHash<QString, LatencyHistogram> latencyHistograms;
+    QElapsedTimer clock;
+    int nextRequestId;
+    bool hedgingEnabled;
+    int maxRetries;
+
+    PathValidator pathValidator;
+    quint64 validatorShapesRevision;
+    CorridorIndex corridorIndex;
 };
 
 #endif // CHATGPTCLIENT_H
\ No newline at end of file
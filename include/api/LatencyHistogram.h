@@ -0,0 +1,31 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QVector>
+#include <QtGlobal>
+
+// Exponentially bucketed latency histogram with decay, so percentiles follow
+// the recent behaviour of a backend instead of its whole history.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 latencyMs);
+
+    // Number of samples recorded (not decayed)
+    int sampleCount() const { return m_sampleCount; }
+
+    // Estimated latency at the given quantile (0.0 - 1.0), or -1 if empty
+    qint64 percentile(double quantile) const;
+
+private:
+    int bucketFor(qint64 latencyMs) const;
+    qint64 bucketUpperBound(int bucket) const;
+
+    QVector<double> m_buckets;
+    double m_totalWeight;
+    int m_sampleCount;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -12,11 +12,14 @@
 #include <QJsonArray>
 #include <QWebChannel>
 #include <QTimer>
+#include "../drone/UpdateBus.h"
 
 // Forward declarations
 class MapFunctions;
 class Mapbox;
 class Geometry;
+class FileWatcher;
+class CorridorMonitor;
 
 // Custom WebEnginePage for debugging
 class DebugWebEnginePage : public QWebEnginePage {
@@ -38,6 +41,8 @@ public:
 public slots:
     // Proxy slots that forward to MapFunctions
     void setDronePositions(const QVector<QVector3D>& positions);
+    void setFleetStates(const QVector<DroneState>& drones);
+    void setTrailLength(int maxPoints, int maxSeconds = 0);
     void updateDronePath(const QJsonObject& geojsonData);
     void saveGeometryData(const QString& geometryData);
     void updateGeometryData(const QString& geometryData);
@@ -46,18 +51,27 @@ public slots:
     void saveGeometricShape(const QString& shapeData, const QString& shapeName);
     void loadGeometricShapes();
     void deleteGeometricShape(const QString& shapeName);
+    bool importGeometricShapes(const QString& filePath, const QString& shapeName = QString());
     void clearDronePathsOnExit();
     void confirmDroneTask(const QString& missionType, const QString& vehicle, const QString& prompt); 
+    void startDroneAnimation(const QString& droneName, double speedMetersPerSecond = 15.0);
+    void startFleetAnimation(const QStringList& droneNames, double speedMetersPerSecond = 15.0);
+    void stopDroneAnimation(const QString& droneName);
+    void stopAllDroneAnimations();
     
 signals:
     void geometricShapeSaved(const QString& shapeName);
+    void importProgress(qint64 bytesRead, qint64 totalBytes, int features);
+    void importFinished(int features, const QString& error);
+    // A flying drone's position reaches into a zone or another drone's corridor
+    void corridorConflictsChanged(const QString& droneName, const QJsonArray& conflicts);
     void droneAnimationCompleted(); 
     
 private:
     QStackedWidget* m_stackedWidget;
     QWebEngineView* m_webView;
     QString m_lastGeojsonPath;
-    QTimer* m_fileCheckTimer; 
+    FileWatcher* m_fileWatcher;
     
     // Map functions handler
     MapFunctions* m_mapFunctions;
@@ -67,6 +81,9 @@ private:
     
     // Geometry handler
     Geometry* m_geometry;
+    
+    // Live corridor checks of the fleet
+    CorridorMonitor* m_corridorMonitor;
 };
 
 #endif // MAPVIEWER_H
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <QLabel>
 #include <QTimer>
 #include <QLineEdit>
+#include <QPushButton>
 
 class TopBar : public QToolBar {
     Q_OBJECT
@@ -12,6 +13,10 @@ public:
     explicit TopBar(QWidget* parent = nullptr);
     ~TopBar() { if (dateTimeTimer) dateTimeTimer->stop(); }
 
+signals:
+    // The user asked to load geofences from a GeoJSON file
+    void importShapesRequested();
+
 private slots:
     void updateDateTime();
 
@@ -19,6 +24,7 @@ private:
     QLabel* dateTimeLabel;
     QTimer* dateTimeTimer;
     QLineEdit* searchBar;
+    QPushButton* importButton;
 };
 
 #endif // TOPBAR_H 
\ No newline at end of file
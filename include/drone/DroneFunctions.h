@@ -10,6 +10,9 @@ public:
     static bool land(double x, double y, double z, const QString& droneName);
     static bool arm(const QString& droneName);
     static bool disarm(const QString& droneName);
+    
+    // Write <drone>_path.geojson files in addition to publishing on the UpdateBus
+    static void setPersistenceEnabled(bool enabled);
 };
 
 #endif // DRONEFUNCTIONS_H 
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef FLEETPATHSTORE_H
+#define FLEETPATHSTORE_H
+
+#include <QObject>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+// In-memory collection of the current flight path of every drone, indexed by
+// drone name. Every change is published on the UpdateBus. When persistence is
+// enabled changes are also written incrementally: each drone keeps its own
+// <name>_path.geojson segment, with the name percent-encoded, and every
+// change is appended to all_drone_paths.log. The log is compacted into the
+// binary all_drone_paths.dgb snapshot (see BinaryGeometryFile) once it grows
+// past a multiple of the fleet size. Snapshot features hold the drone name
+// they are stored under, so paths come back under the same key.
+//
+// Like the shapes (see ShapeStore), paths live for one session and clear()
+// runs on exit. The files are read on start to recover the paths of a
+// session that crashed or was killed.
+class FleetPathStore : public QObject
+{
+    Q_OBJECT
+public:
+    static FleetPathStore& instance();
+
+    // Replace (or add) the path of a drone
+    void replacePath(const QString& droneName, const QJsonObject& feature);
+    // Same for a path that is only drawn: it is published and kept in memory,
+    // but never written to the log, its segment or the snapshot
+    void showPath(const QString& droneName, const QJsonObject& feature);
+    void removePath(const QString& droneName);
+
+    bool contains(const QString& droneName) const { return m_paths.contains(droneName); }
+    QJsonObject path(const QString& droneName) const { return m_paths.value(droneName); }
+    QStringList droneNames() const { return m_paths.keys(); }
+
+    // All paths as a FeatureCollection, rebuilt lazily after changes
+    QJsonObject featureCollection() const;
+
+    // Incremented on every change, lets views skip unchanged collections
+    quint64 revision() const { return m_revision; }
+
+    // Drop all paths and the files backing them
+    void clear();
+
+    // Files are an optional sink, views are fed through the UpdateBus
+    void setPersistenceEnabled(bool enabled) { m_persistenceEnabled = enabled; }
+    bool isPersistenceEnabled() const { return m_persistenceEnabled; }
+
+    // Write the snapshot and truncate the append log
+    bool compact();
+
+    // Every path as one GeoJSON FeatureCollection, for other tools
+    bool exportGeoJson(const QString& path);
+
+private:
+    explicit FleetPathStore(QObject* parent = nullptr);
+    ~FleetPathStore();
+
+    // Prevent copying
+    FleetPathStore(const FleetPathStore&) = delete;
+    FleetPathStore& operator=(const FleetPathStore&) = delete;
+
+    void load();
+    void appendLogRecord(const QJsonObject& record);
+    void writeSegment(const QString& droneName, const QJsonObject& feature);
+    void compactIfNeeded();
+
+    QString snapshotPath() const;
+    QString legacySnapshotPath() const;
+    QString logPath() const;
+    QString segmentPath(const QString& droneName) const;
+
+    QString m_directory;
+    QMap<QString, QJsonObject> m_paths;
+    QSet<QString> m_displayOnly;
+    quint64 m_revision;
+    int m_logRecords;
+    bool m_persistenceEnabled;
+
+    mutable QJsonObject m_cachedCollection;
+    mutable quint64 m_cachedRevision;
+};
+
+#endif // FLEETPATHSTORE_H
@@ -0,0 +1,133 @@
+#ifndef UPDATEBUS_H
+#define UPDATEBUS_H
+
+#include <QObject>
+#include <QMap>
+#include <QHash>
+#include <QStringList>
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <QMetaType>
+
+// Current path of one drone, planned or flown by commands. An empty feature
+// means the path was removed.
+struct PathSnapshot {
+    QString droneName;
+    QJsonObject feature;
+    quint64 revision = 0;
+};
+
+// All geometric shapes (geofences) as a FeatureCollection, published when
+// the whole set is (re)loaded
+struct ShapesSnapshot {
+    QJsonObject collection;
+    quint64 revision = 0;
+};
+
+// Shapes added, replaced or removed since the last publication, by shape id
+struct ShapeChanges {
+    QHash<QString, QJsonObject> upserted;
+    QStringList removed;
+    quint64 revision = 0;
+};
+
+// Latest known drone positions (x = longitude, y = latitude, z = altitude)
+struct PositionsSnapshot {
+    QVector<QVector3D> positions;
+    qint64 timestamp = 0;
+};
+
+// Live state of one drone of the fleet, keyed by a stable id
+struct DroneState {
+    enum Status {
+        Idle = 0,
+        Flying,
+        Returning,
+        Warning,
+        Lost
+    };
+
+    QString id;
+    // Doubles, a float longitude steps in about 1 m around lng 78
+    double lng = 0.0;
+    double lat = 0.0;
+    double alt = 0.0;
+    float heading = 0.0f; // degrees clockwise from north
+    Status status = Idle;
+};
+
+// Latest state of every drone of the fleet
+struct FleetSnapshot {
+    QVector<DroneState> drones;
+    qint64 timestamp = 0;
+};
+
+typedef QSharedPointer<const PathSnapshot> PathSnapshotPtr;
+typedef QSharedPointer<const ShapesSnapshot> ShapesSnapshotPtr;
+typedef QSharedPointer<const ShapeChanges> ShapeChangesPtr;
+typedef QSharedPointer<const PositionsSnapshot> PositionsSnapshotPtr;
+typedef QSharedPointer<const FleetSnapshot> FleetSnapshotPtr;
+
+Q_DECLARE_METATYPE(PathSnapshotPtr)
+Q_DECLARE_METATYPE(ShapesSnapshotPtr)
+Q_DECLARE_METATYPE(ShapeChangesPtr)
+Q_DECLARE_METATYPE(PositionsSnapshotPtr)
+Q_DECLARE_METATYPE(FleetSnapshotPtr)
+
+// In-process publish/subscribe hub between producers of path, shape and
+// position data (planner, drone commands, geometry editor) and the views that
+// display them. Snapshots are immutable and shared, so subscribers on any
+// thread can keep them without copying. The latest snapshot of every topic is
+// retained for views created after it was published.
+class UpdateBus : public QObject
+{
+    Q_OBJECT
+public:
+    static UpdateBus& instance();
+
+    void publishPath(const QString& droneName, const QJsonObject& feature);
+    void publishPathRemoved(const QString& droneName);
+    // Trail of arm / takeoff / goto commands, kept apart from planned paths
+    void publishCommandTrail(const QString& droneName, const QJsonObject& feature);
+    void publishShapes(const QJsonObject& collection);
+    void publishShapeChanges(const QHash<QString, QJsonObject>& upserted, const QStringList& removed);
+    void publishPositions(const QVector<QVector3D>& positions);
+    void publishFleet(const QVector<DroneState>& drones);
+
+    QMap<QString, PathSnapshotPtr> latestPaths() const { return m_paths; }
+    PathSnapshotPtr latestPath(const QString& droneName) const { return m_paths.value(droneName); }
+    PathSnapshotPtr latestCommandTrail(const QString& droneName) const { return m_commandTrails.value(droneName); }
+    // Last full set of shapes, edits after it only arrive as ShapeChanges;
+    // ShapeStore holds the current set
+    ShapesSnapshotPtr latestShapes() const { return m_shapes; }
+    PositionsSnapshotPtr latestPositions() const { return m_positions; }
+    FleetSnapshotPtr latestFleet() const { return m_fleet; }
+
+signals:
+    void pathPublished(PathSnapshotPtr snapshot);
+    void commandTrailPublished(PathSnapshotPtr snapshot);
+    void shapesPublished(ShapesSnapshotPtr snapshot);
+    void shapeChangesPublished(ShapeChangesPtr changes);
+    void positionsPublished(PositionsSnapshotPtr snapshot);
+    void fleetPublished(FleetSnapshotPtr snapshot);
+
+private:
+    explicit UpdateBus(QObject* parent = nullptr);
+    ~UpdateBus();
+
+    // Prevent copying
+    UpdateBus(const UpdateBus&) = delete;
+    UpdateBus& operator=(const UpdateBus&) = delete;
+
+    QMap<QString, PathSnapshotPtr> m_paths;
+    QMap<QString, PathSnapshotPtr> m_commandTrails;
+    ShapesSnapshotPtr m_shapes;
+    PositionsSnapshotPtr m_positions;
+    FleetSnapshotPtr m_fleet;
+    quint64 m_revision;
+};
+
+#endif // UPDATEBUS_H
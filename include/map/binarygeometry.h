@@ -0,0 +1,65 @@
+#ifndef BINARYGEOMETRY_H
+#define BINARYGEOMETRY_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "spatialindex.h"
+
+// Compact binary FeatureCollection used for the drone_geojson snapshots, read
+// through a memory map. The header and offset table can be used in place;
+// a feature is only decoded when it is asked for.
+//
+// Layout, little-endian:
+//   header        "DGB1", uint32 version, uint32 feature count, uint32 reserved,
+//                 float64 minX, minY, maxX, maxY of all features
+//   offset table  per feature: uint64 offset, uint32 size, uint32 reserved,
+//                 float64 minX, minY, maxX, maxY
+//   features      uint32 size + compact JSON of the feature without geometry,
+//                 uint8 geometry type, uint8 stride, uint16 reserved, then
+//                 in pre-order the varint child count of every nested array
+//                 and the zigzag varint delta of every position to the
+//                 previous one: lng and lat in 1e-7 degrees, altitude in
+//                 centimeters
+// Geometries that cannot be packed (GeometryCollection, mixed dimensions)
+// are stored as uint32 size + compact JSON with geometry type RAW_GEOMETRY.
+class BinaryGeometryFile
+{
+public:
+    BinaryGeometryFile();
+    ~BinaryGeometryFile();
+
+    // Writes the features atomically; boxes are computed when not given
+    static bool write(const QString& path, const QVector<QJsonObject>& features,
+                      const QVector<BoundingBox>& boxes = QVector<BoundingBox>());
+
+    // Maps the file and validates the header and offset table
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+    QString errorString() const { return m_error; }
+
+    int count() const { return m_count; }
+    BoundingBox bounds() const;
+    BoundingBox featureBounds(int index) const;
+    // Empty object when the record is damaged
+    QJsonObject feature(int index) const;
+
+    // Every feature as a GeoJSON FeatureCollection, for interop
+    QJsonObject toFeatureCollection() const;
+
+private:
+    // Prevent copying
+    BinaryGeometryFile(const BinaryGeometryFile&) = delete;
+    BinaryGeometryFile& operator=(const BinaryGeometryFile&) = delete;
+
+    QFile m_file;
+    const uchar* m_data;
+    qint64 m_size;
+    int m_count;
+    QString m_error;
+};
+
+#endif // BINARYGEOMETRY_H
@@ -0,0 +1,50 @@
+#ifndef COORDINATECODEC_H
+#define COORDINATECODEC_H
+
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+#include <QJsonObject>
+#include <QJsonArray>
+
+// Packs coordinates into little-endian Float32/Float64 buffers, base64 encoded,
+// so the map page can decode them straight into typed arrays instead of
+// parsing long JSON number lists.
+//
+// Packed geometry format, decoded by unpackGeometry() in the map page:
+//   { "type", "packed": base64 Float64 positions, "stride": 2|3,
+//     "counts": [[...], ...] }
+// counts holds the child sizes of every nesting level above the positions
+// (e.g. ring sizes for a Polygon, ring counts then ring sizes for a
+// MultiPolygon).
+class CoordinateCodec
+{
+public:
+    static QString packFloat32(const QVector<float>& values);
+    static QString packFloat64(const QVector<double>& values);
+
+    // x, y, z of every position as Float32
+    static QString packPositions(const QVector<QVector3D>& positions);
+
+    // Array of [lng, lat(, alt)] positions as Float64, stride is set to 2 or 3
+    static QString packPath(const QJsonArray& coordinates, int* stride);
+
+    // Geometries that cannot be packed (GeometryCollection, mixed
+    // dimensions) are returned unchanged
+    static QJsonObject packGeometry(const QJsonObject& geometry);
+    static QJsonObject packFeature(const QJsonObject& feature);
+    static QJsonObject packFeatureCollection(const QJsonObject& collection);
+
+    // JSON as a JavaScript string literal, so the page can hand the text to
+    // its ingestion worker instead of parsing it on the main thread
+    static QString scriptStringLiteral(const QJsonObject& json);
+    // Any text (drone names, ids) as a quoted JavaScript string literal
+    static QString scriptStringLiteral(const QString& text);
+
+private:
+    static int nestingDepth(const QString& geometryType);
+    static bool flatten(const QJsonArray& coordinates, int depth, int level,
+                        QVector<double>& values, QVector<QJsonArray>& counts, int& stride);
+};
+
+#endif // COORDINATECODEC_H
@@ -0,0 +1,129 @@
+#ifndef CORRIDORINDEX_H
+#define CORRIDORINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <QPolygonF>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "planargeometry.h"
+#include "spatialindex.h"
+
+// How far a vehicle may be from where it reports or plans to be. The
+// horizontal default keeps the corridors of bases 10 m apart separate.
+struct PositionUncertainty {
+    double horizontalMeters = 4.0;
+    double verticalMeters = 5.0;
+};
+
+// A corridor (or live position) that reaches into a zone or another corridor
+struct CorridorConflict {
+    enum Type {
+        Zone = 0,   // within the zone's clearance and altitude band
+        Corridor    // overlaps another drone's corridor
+    };
+
+    QString droneName;
+    int segment = -1;       // -1 for a live position
+    Type type = Zone;
+    QString otherId;        // zone id or drone name
+    QString otherName;      // zone name
+    int otherSegment = -1;
+    double gapMeters = 0.0; // horizontal distance minus every margin, <= 0
+
+    QJsonObject toJson() const;
+};
+
+// Flight paths buffered into 3D corridors: every segment is a capsule with
+// the vehicle's horizontal uncertainty as radius, spanning the segment's
+// altitudes grown by the vertical uncertainty. Corridor segments and the
+// polygon zones they must clear each sit in an STR R-tree of degree boxes,
+// so a corridor or a live position is only tested against what its box
+// touches instead of every path, shape and vertex. Distances are measured
+// in local meters around each zone's center or around the segment at hand,
+// never around one origin for the whole country.
+//
+// Zones may limit their altitude band with "minAltitude" / "maxAltitude" and
+// grow with "clearance" properties, in meters. Paths without altitudes, and
+// zones without a band, are treated as spanning every altitude. Corridors
+// are compared in space only, two crossings at different times still
+// conflict.
+//
+// The first segment of a path is its take-off from the drone's base. Bases
+// sit a few meters apart, so launch segments are only checked against
+// zones, never against other corridors or live positions.
+class CorridorIndex
+{
+public:
+    CorridorIndex();
+
+    // Polygon and MultiPolygon features of the collection become zones
+    void setZones(const QJsonObject& collection);
+    int zoneCount() const { return m_zones.size(); }
+
+    // Uncertainty set on a path by "horizontalUncertainty" /
+    // "verticalUncertainty" properties, in meters, or the fallback
+    static PositionUncertainty uncertaintyOf(const QJsonObject& pathFeature,
+                                             const PositionUncertainty& fallback = PositionUncertainty());
+
+    // LineString path feature of a drone, replacing its previous corridor
+    void setCorridor(const QString& droneName, const QJsonObject& pathFeature,
+                     const PositionUncertainty& uncertainty);
+    void removeCorridor(const QString& droneName);
+    bool hasCorridor(const QString& droneName) const { return m_corridors.contains(droneName); }
+    QStringList droneNames() const { return m_corridors.keys(); }
+
+    // Ground footprint of a corridor as a Polygon / MultiPolygon, for drawing
+    QJsonObject footprint(const QString& droneName) const;
+
+    // Conflicts of a corridor's segments from fromSegment on, with zones
+    // and / or the corridors of other drones
+    QVector<CorridorConflict> conflicts(const QString& droneName, int fromSegment = 0,
+                                        bool withZones = true, bool withCorridors = true) const;
+
+    // Conflicts of a live position with zones and other drones' corridors
+    QVector<CorridorConflict> positionConflicts(const QString& droneName, double lng, double lat, double alt,
+                                                const PositionUncertainty& uncertainty) const;
+
+private:
+    struct Zone {
+        QString id;
+        QString name;
+        LocalProjection projection;
+        QVector<QVector<QPolygonF>> polygons;  // in the zone's projection
+        double clearance = 0.0;
+        double minAltitude;
+        double maxAltitude;
+    };
+
+    struct Corridor {
+        QJsonArray coordinates;
+        PositionUncertainty uncertainty;
+        QPolygonF points;           // [lng, lat] vertices
+        QVector<double> altitudes;  // empty when the path has none
+    };
+
+    struct SegmentRef {
+        QString droneName;
+        int segment;
+    };
+
+    void prepareCorridor(Corridor& corridor) const;
+    void ensureSegmentIndex() const;
+    void segmentBand(const Corridor& corridor, int segment, double& low, double& high) const;
+    BoundingBox segmentBox(const Corridor& corridor, int segment) const;
+    double zoneDistance(const Zone& zone, const QPointF& a, const QPointF& b) const;
+
+    QVector<Zone> m_zones;
+    SpatialIndex m_zoneIndex;
+    QMap<QString, Corridor> m_corridors;
+
+    // Every corridor segment, rebuilt lazily after corridors change
+    mutable SpatialIndex m_segmentIndex;
+    mutable QVector<SegmentRef> m_segments;
+    mutable bool m_segmentsDirty;
+};
+
+#endif // CORRIDORINDEX_H
@@ -0,0 +1,47 @@
+#ifndef CORRIDORMONITOR_H
+#define CORRIDORMONITOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QJsonArray>
+#include "corridorindex.h"
+#include "../drone/UpdateBus.h"
+
+// Live corridor monitoring: keeps a CorridorIndex in step with the planned
+// paths on the UpdateBus and the ShapeStore zones, and checks every drone of
+// each fleet update against the zones and the other drones' corridors. A
+// tick costs one R-tree query per drone; conflicts are only reported when
+// they change for a drone.
+class CorridorMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CorridorMonitor(QObject* parent = nullptr);
+
+    // Used for drones and paths without their own uncertainty
+    void setDefaultUncertainty(const PositionUncertainty& uncertainty);
+    void setUncertainty(const QString& droneName, const PositionUncertainty& uncertainty);
+
+signals:
+    // Empty conflicts when the drone is clear again
+    void conflictsChanged(const QString& droneName, const QJsonArray& conflicts);
+
+private slots:
+    void handlePathPublished(PathSnapshotPtr snapshot);
+    void handleFleetPublished(FleetSnapshotPtr snapshot);
+
+private:
+    PositionUncertainty uncertaintyOf(const QString& droneName) const;
+    void refreshZones();
+
+    CorridorIndex m_index;
+    PositionUncertainty m_defaultUncertainty;
+    QHash<QString, PositionUncertainty> m_uncertainties;
+    quint64 m_zonesRevision;
+
+    // Last conflicts reported per drone
+    QHash<QString, QJsonArray> m_reported;
+};
+
+#endif // CORRIDORMONITOR_H
@@ -0,0 +1,59 @@
+#ifndef DRONEANIMATION_H
+#define DRONEANIMATION_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QTimer>
+
+// Flies any number of drones along their paths on one shared mission clock.
+// Every telemetry tick produces one batch with a keyframe (position, heading,
+// velocity, timestamp) per moving drone; the map page interpolates between
+// batches and renders all drones with a single source update per frame.
+class DroneAnimationEngine : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DroneAnimationEngine(QObject* parent = nullptr, int telemetryIntervalMs = 200);
+    ~DroneAnimationEngine();
+
+    // Starts (or restarts) a drone at the beginning of the given path
+    bool startDrone(const QString& droneId, const QJsonArray& coordinates, double speedMetersPerSecond);
+    void stopDrone(const QString& droneId);
+    void stopAll();
+
+    bool isAnimating(const QString& droneId) const { return m_tracks.contains(droneId); }
+    QStringList activeDrones() const { return m_tracks.keys(); }
+
+    // Milliseconds on the clock keyframes are stamped with
+    qint64 missionTime() const { return m_missionClock.elapsed(); }
+
+signals:
+    void keyframesReady(const QJsonArray& keyframes);
+    void droneFinished(const QString& droneId);
+    void allFinished();
+
+private slots:
+    void tick();
+
+private:
+    struct Track {
+        QJsonArray path;
+        QVector<double> distances;
+        double speed = 0.0;
+        qint64 startMs = 0;
+    };
+
+    static QJsonObject keyframeAt(const QString& droneId, const Track& track, qint64 missionTimeMs);
+
+    QElapsedTimer m_missionClock;
+    QTimer* m_telemetryTimer;
+    QHash<QString, Track> m_tracks;
+};
+
+#endif // DRONEANIMATION_H
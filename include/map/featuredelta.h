@@ -0,0 +1,51 @@
+#ifndef FEATUREDELTA_H
+#define FEATUREDELTA_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QJsonObject>
+#include <QJsonArray>
+
+// Tracks the features of one map source by id and version, and produces the
+// delta (added/changed features and removed ids) since the last one sent, so
+// a single changed feature does not require re-uploading the whole source.
+//
+// Delta format, applied by applyFeatureDelta() in the map page:
+//   { "reset": bool, "upsert": [{ "id", "version", "feature" }], "remove": [id] }
+class FeatureDeltaTracker
+{
+public:
+    FeatureDeltaTracker();
+
+    // Returns false when the feature is identical to the one already tracked
+    bool upsert(const QString& id, const QJsonObject& feature);
+    void remove(const QString& id);
+
+    // Replace the whole set, only differences end up in the next delta
+    void replaceAll(const QHash<QString, QJsonObject>& features);
+
+    bool contains(const QString& id) const { return m_features.contains(id); }
+    QJsonObject feature(const QString& id) const { return m_features.value(id).feature; }
+    QList<QString> ids() const { return m_features.keys(); }
+
+    bool hasPendingChanges() const { return m_reset || !m_dirty.isEmpty() || !m_removed.isEmpty(); }
+
+    // Next delta to send; resync() makes it a full reset (e.g. after a page reload)
+    QJsonObject takeDelta();
+    void resync() { m_reset = true; }
+
+private:
+    struct Entry {
+        QJsonObject feature;
+        quint64 version = 0;
+    };
+
+    QHash<QString, Entry> m_features;
+    QSet<QString> m_dirty;
+    QSet<QString> m_removed;
+    quint64 m_nextVersion;
+    bool m_reset;
+};
+
+#endif // FEATUREDELTA_H
@@ -0,0 +1,49 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QMap>
+#include <QSet>
+#include <QDateTime>
+#include <QStringList>
+
+// Debounced file change notifications backed by QFileSystemWatcher (inotify on
+// Linux). The parent directory of every file is watched as well, so files that
+// do not exist yet or are replaced atomically keep being tracked. Nothing is
+// polled: an idle application does no file I/O.
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileWatcher(QObject* parent = nullptr, int debounceMs = 50);
+
+    void watchFile(const QString& filePath);
+    void unwatchFile(const QString& filePath);
+
+signals:
+    // Emitted once per burst of changes with the files whose contents changed
+    void filesChanged(const QStringList& filePaths);
+
+private slots:
+    void handleFileChanged(const QString& filePath);
+    void handleDirectoryChanged(const QString& directoryPath);
+    void flushChanges();
+
+private:
+    struct FileState {
+        QDateTime lastModified;
+        qint64 size = -1;
+    };
+
+    FileState currentState(const QString& filePath) const;
+    void ensureWatched(const QString& filePath);
+
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_debounceTimer;
+    QMap<QString, FileState> m_files;
+    QSet<QString> m_pendingFiles;
+};
+
+#endif // FILEWATCHER_H
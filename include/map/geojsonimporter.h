@@ -0,0 +1,63 @@
+#ifndef GEOJSONIMPORTER_H
+#define GEOJSONIMPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include "spatialindex.h"
+
+// Imports large airspace datasets (tens of thousands of polygons) into the
+// ShapeStore. The file is read in chunks on a worker thread and split into
+// single features by a byte scanner, so only one feature at a time is parsed
+// by QJsonDocument instead of the whole file.
+//
+// Accepted input:
+//  - a GeoJSON FeatureCollection
+//  - GeoJSON text sequences or newline-delimited features (one Feature or
+//    geometry object per record)
+//
+// Bounding boxes and a simplified rendering geometry are computed per feature
+// while reading; the store receives everything in one bulk insert at the end
+// and the map draws the simplified set.
+class GeoJsonImporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GeoJsonImporter(QObject* parent = nullptr);
+    ~GeoJsonImporter();
+
+    // Starts importing, returns false while another import is running.
+    // Features without a "name" property get shapeName, or the file name.
+    bool start(const QString& filePath, const QString& shapeName = QString());
+    void cancel();
+    bool isRunning() const { return m_watcher.isRunning(); }
+
+signals:
+    // Emitted from the worker thread about once per chunk
+    void progress(qint64 bytesRead, qint64 totalBytes, int features);
+    // error is empty on success
+    void finished(int features, const QString& error);
+
+private slots:
+    void handleReadFinished();
+
+private:
+    struct ReadResult {
+        QVector<QJsonObject> features;
+        QVector<BoundingBox> boxes;
+        QVector<QJsonObject> rendered;
+        int skipped = 0;
+        QString error;
+    };
+
+    ReadResult read(const QString& filePath, const QString& shapeName);
+    static QJsonObject simplifiedFeature(const QJsonObject& feature, const BoundingBox& box);
+
+    QFutureWatcher<ReadResult> m_watcher;
+    QAtomicInt m_cancelled;
+};
+
+#endif // GEOJSONIMPORTER_H
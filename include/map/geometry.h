@@ -11,6 +11,8 @@
 #include <QDateTime>
 #include <QDebug>
 
+class GeoJsonImporter;
+
 class Geometry : public QObject
 {
     Q_OBJECT
@@ -24,14 +26,26 @@ public:
     void saveGeometricShape(const QString& shapeData, const QString& shapeName);
     void loadGeometricShapes();
     void deleteGeometricShape(const QString& shapeName);
+    // Drops the session's shapes and drawing files
     void clearAllGeometryOnExit();
     
+    // Streams a large GeoJSON / GeoJSON sequence file into the shapes on a
+    // worker thread; features without a name get shapeName (or the file name)
+    bool importGeometricShapes(const QString& filePath, const QString& shapeName = QString());
+    void cancelImport();
+    
+    // GeoJSON copy of the shapes for other tools, the store itself keeps a
+    // binary snapshot
+    bool exportGeometricShapes(const QString& filePath = QString());
+    
 signals:
     void geometricShapeSaved(const QString& shapeName);
+    void importProgress(qint64 bytesRead, qint64 totalBytes, int features);
+    void importFinished(int features, const QString& error);
     
 private:
     QWebEngineView* m_webView;
-    QDateTime m_lastShapesFileModified;
+    GeoJsonImporter* m_importer;
 };
 
 #endif // GEOMETRY_H
\ No newline at end of file
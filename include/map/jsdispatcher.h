@@ -0,0 +1,56 @@
+#ifndef JSDISPATCHER_H
+#define JSDISPATCHER_H
+
+#include <QObject>
+#include <QWebEngineView>
+#include <QTimer>
+#include <QVector>
+#include <QHash>
+#include <QString>
+
+// Queues the scripts sent to one web view and runs them as a single combined
+// script once per display frame, so bursts of updates cost one IPC hop to the
+// renderer instead of one per call.
+//
+// Calls with a key replace the pending call with the same key (e.g. the full
+// path of one drone), so only the latest state is sent. A replaced call moves
+// to the end of the queue to keep its order relative to newer unkeyed calls.
+// Every script runs in its own try block, a failing one does not stop the rest.
+class JsDispatcher : public QObject
+{
+    Q_OBJECT
+public:
+    static const int FRAME_INTERVAL_MS = 16;
+
+    // The dispatcher of a view, created on first use and owned by the view
+    static JsDispatcher* forView(QWebEngineView* view);
+
+    void call(const QString& script);
+    void call(const QString& key, const QString& script);
+
+    // Run everything queued so far right away
+    void flush();
+
+    int pendingCount() const { return m_pending.size() - m_replaced; }
+
+private:
+    explicit JsDispatcher(QWebEngineView* view);
+
+    // Prevent copying
+    JsDispatcher(const JsDispatcher&) = delete;
+    JsDispatcher& operator=(const JsDispatcher&) = delete;
+
+    struct PendingCall {
+        QString key;
+        QString script;
+    };
+
+    QWebEngineView* m_view;
+    QTimer* m_flushTimer;
+    QVector<PendingCall> m_pending;
+    // Index of the pending call of every key
+    QHash<QString, int> m_keyIndex;
+    int m_replaced;
+};
+
+#endif // JSDISPATCHER_H
@@ -10,6 +10,8 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QWebChannel>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
 #include <QDebug>
 
 class Mapbox : public QObject {
@@ -20,21 +22,29 @@ public:
 
     void loadMap();
     QString getMapboxToken() const { return m_mapboxToken; }
+    
+    // Use the local style and tile store instead of the Mapbox servers
+    void setOfflineTilesEnabled(bool enabled) { m_offlineTilesEnabled = enabled; }
 
 public slots:
     void saveGeometricShape(const QString& geoJson, const QString& shapeName);
     void updateDronePath(const QString& geoJson);
     void updateGeometricShapes(const QString& geoJson);
     void moveDroneAlongPath(const QJsonArray& coordinates, int currentIndex);
+    
+    // Called by the page whenever the integer zoom level changes
+    void setZoomBand(int band);
 
 signals:
     void geometricShapeSaved(const QString& shapeName);
     void dronePathUpdated();
+    void zoomBandChanged(int band);
 
 private:
     QWebEngineView* m_webView;
     QString m_lastGeojsonPath;
     QString m_mapboxToken;
+    bool m_offlineTilesEnabled;
 };
 
 #endif // MAPBOX_H
@@ -11,13 +11,19 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QDateTime>
-#include <QCryptographicHash>
 #include <QMap>
 #include <QRandomGenerator>
 #include <QColor>
 #include <QMessageBox>
 #include <QTimer>
 #include <QTextStream>
+#include <QSet>
+#include <QHash>
+#include "../drone/UpdateBus.h"
+#include "featuredelta.h"
+#include "droneanimation.h"
+#include "maplod.h"
+#include "jsdispatcher.h"
 
 class MapFunctions : public QObject {
     Q_OBJECT
@@ -27,10 +33,21 @@ public:
     
 public slots:
     void setDronePositions(const QVector<QVector3D>& positions);
+    
+    // Fleet overlay keyed by drone id, meant for high-rate telemetry: the
+    // page creates a feature once per drone and afterwards only moves it
+    void setFleetStates(const QVector<DroneState>& drones);
+    
+    // Trails of the fleet overlay keep the last maxPoints positions of every
+    // drone, and with maxSeconds > 0 only those of the last maxSeconds
+    void setTrailLength(int maxPoints, int maxSeconds = 0);
+    // Stores every path of the collection in FleetPathStore under its
+    // "drone" (or "name") property
     void updateDronePath(const QJsonObject& geojsonData);
     void saveGeometryData(const QString& geometryData);
     void updateGeometryData(const QString& geometryData);
     void checkForFileChanges();
+    void refreshDronePaths();
     void setActiveDrone(const QString& droneName);
     void saveGeometricShape(const QString& shapeData, const QString& shapeName);
     void loadGeometricShapes();
@@ -38,29 +55,68 @@ public slots:
     void clearDronePathsOnExit();
     void confirmDroneTask(const QString& missionType, const QString& vehicle, const QString& prompt); 
     
+    // Fly drones along their current paths; any number can move at once and
+    // the page interpolates between the keyframes sent at telemetry rate
+    void startDroneAnimation(const QString& droneName, double speedMetersPerSecond = 15.0);
+    void startFleetAnimation(const QStringList& droneNames, double speedMetersPerSecond = 15.0);
+    void stopDroneAnimation(const QString& droneName);
+    void stopAllDroneAnimations();
+    
+    // Paths and drone markers are drawn at the detail of this zoom level
+    void setZoomBand(int band);
+    
 signals:
     void geometricShapeSaved(const QString& shapeName);
     void droneAnimationCompleted(); 
     
 private slots:
-    void updateDronePosition(); 
+    void pushDroneKeyframes(const QJsonArray& keyframes);
+    
+    // UpdateBus subscribers
+    void handlePathPublished(PathSnapshotPtr snapshot);
+    void handleShapesPublished(ShapesSnapshotPtr snapshot);
+    void handleShapeChangesPublished(ShapeChangesPtr changes);
+    void handlePositionsPublished(PositionsSnapshotPtr snapshot);
+    void handleFleetPublished(FleetSnapshotPtr snapshot);
+    void handlePageLoaded(bool ok);
     
 private:
+    // Sends the pending changes of one map source as a per-feature delta
+    void pushFeatureDelta(const QString& sourceId, FeatureDeltaTracker& tracker);
+    QJsonObject decoratePathFeature(QJsonObject feature);
+    void syncMissionClock();
+    
     QWebEngineView* m_webView;
-    QString m_lastGeojsonHash;
+    // Coalesces the scripts sent to the page, one IPC hop per frame
+    JsDispatcher* m_js;
     QString m_lastGeojsonPath;
     QDateTime m_lastFileModified;
     QString m_activeDroneName = "Atlas"; 
     QMap<QString, QString> m_dronePathColors; 
     QDateTime m_lastShapesFileModified; 
-    QDateTime m_lastDronePathsFileModified; 
     
-    // Properties for drone animation
-    QTimer* m_animationTimer;
-    QJsonArray m_currentPath;
-    int m_currentPathIndex;
-    double m_animationSpeed; 
-    bool m_isAnimating;
+    // Drone paths received from the UpdateBus, pushed to the page in bursts
+    QMap<QString, QJsonObject> m_dronePaths;
+    QSet<QString> m_dirtyPaths;
+    QTimer* m_pathRefreshTimer;
+    
+    // Decimated paths and drone clusters for the current zoom band
+    MapLevelOfDetail m_lod;
+    int m_zoomBand;
+    QVector<QVector3D> m_lastPositions;
+    
+    // Stable feature slot of every drone on the fleet overlay
+    QHash<QString, int> m_fleetSlots;
+    QVector<int> m_freeFleetSlots;
+    int m_trailMaxPoints;
+    int m_trailMaxSeconds;
+    
+    // What the page's feature stores currently hold
+    FeatureDeltaTracker m_pathFeatures;
+    FeatureDeltaTracker m_shapeFeatures;
+    
+    // Drone animation
+    DroneAnimationEngine* m_animationEngine;
 };
 
 #endif // MAPFUNCTIONS_H
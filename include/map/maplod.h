@@ -0,0 +1,55 @@
+#ifndef MAPLOD_H
+#define MAPLOD_H
+
+#include <QHash>
+#include <QVector>
+#include <QVector3D>
+#include <QString>
+#include <QJsonObject>
+#include <QJsonArray>
+
+// Zoom dependent level of detail for what the map draws:
+//  - path vertices are decimated (Douglas-Peucker) to what is visible at the
+//    current zoom band, cached per path and band until the path changes
+//  - drone markers are merged into grid clusters at low zoom
+// A zoom band is the integer zoom level reported by the map page.
+class MapLevelOfDetail
+{
+public:
+    // From this band on paths are drawn with every vertex
+    static const int FULL_DETAIL_BAND = 16;
+    // Below this band drone markers are clustered
+    static const int CLUSTER_MAX_BAND = 12;
+
+    MapLevelOfDetail();
+
+    // Path feature decimated for the zoom band; LineString and
+    // MultiLineString geometries are simplified, others returned unchanged.
+    // Simplified geometries are cached by id, call removePath() when the
+    // geometry of a path changes.
+    QJsonObject pathForBand(const QString& id, const QJsonObject& feature, int band);
+    void removePath(const QString& id) { m_geometryCache.remove(id); }
+    void clear() { m_geometryCache.clear(); }
+
+    struct Cluster {
+        double lng = 0.0;
+        double lat = 0.0;
+        double alt = 0.0;
+        int count = 0;
+    };
+
+    // Grid clusters of positions (x = lng, y = lat, z = alt) at the zoom band
+    static QVector<Cluster> clusterPositions(const QVector<QVector3D>& positions, int band);
+
+    // Douglas-Peucker over [lng, lat] positions, endpoints are always kept
+    static QJsonArray simplifyLine(const QJsonArray& coordinates, double toleranceMeters);
+    // Size of one screen pixel in meters at the zoom band and latitude
+    static double toleranceForBand(int band, double latitude);
+
+private:
+
+    // Simplified geometry per path id and zoom band
+    QHash<QString, QHash<int, QJsonObject>> m_geometryCache;
+};
+
+#endif // MAPLOD_H
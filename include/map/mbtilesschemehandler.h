@@ -0,0 +1,49 @@
+#ifndef MBTILESSCHEMEHANDLER_H
+#define MBTILESSCHEMEHANDLER_H
+
+#include <QObject>
+#include <QWebEngineUrlSchemeHandler>
+#include <QWebEngineUrlRequestJob>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QByteArray>
+#include <QString>
+
+// Serves an offline map from a local MBTiles (SQLite) vector tile store over
+// the mbtiles: scheme, so the map does not depend on network tile fetches:
+//   mbtiles://style/style.json      local style pointing at the tiles below
+//   mbtiles://tiles/tiles.json      TileJSON built from the metadata table
+//   mbtiles://tiles/{z}/{x}/{y}.pbf tile data (gzip inflated, TMS y flipped)
+// registerScheme() must be called before the QApplication is created.
+class MbtilesSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+public:
+    static const QByteArray SCHEME;
+
+    static void registerScheme();
+
+    // Default store location, <working dir>/tiles/offline.mbtiles
+    static QString defaultStorePath();
+
+    explicit MbtilesSchemeHandler(const QString& mbtilesPath, QObject* parent = nullptr);
+    ~MbtilesSchemeHandler();
+
+    bool isOpen() const { return m_database.isOpen(); }
+
+    void requestStarted(QWebEngineUrlRequestJob* job) override;
+
+private:
+    QByteArray readTile(int z, int x, int y);
+    QByteArray styleJson() const;
+    QByteArray tileJson();
+
+    static QByteArray inflateGzip(const QByteArray& data);
+
+    QString m_connectionName;
+    QSqlDatabase m_database;
+    QSqlQuery m_tileQuery;
+    QByteArray m_tileJson;
+};
+
+#endif // MBTILESSCHEMEHANDLER_H
@@ -0,0 +1,91 @@
+#ifndef PATHVALIDATOR_H
+#define PATHVALIDATOR_H
+
+#include <QString>
+#include <QVector>
+#include <QMap>
+#include <QPolygonF>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "planargeometry.h"
+#include "spatialindex.h"
+
+// A path segment that enters, crosses or passes too close to a shape
+struct PathViolation {
+    enum Type {
+        Clearance = 0,  // closer to the shape than its clearance
+        Inside,         // segment lies inside a polygon
+        Intersects,     // segment crosses the shape boundary
+        Unsupported     // the path is not a LineString and cannot be checked
+    };
+
+    int segment = -1;  // segment from vertex segment to segment + 1, -1 for the whole path
+    Type type = Clearance;
+    QString shapeId;
+    QString shapeName;
+    double distanceMeters = 0.0;
+
+    QJsonObject toJson() const;
+};
+
+struct PathValidationResult {
+    QString droneName;
+    QVector<PathViolation> violations;
+
+    bool isValid() const { return violations.isEmpty(); }
+    QJsonArray violationsJson() const;
+    // One line per violated segment, for messages to the user
+    QString summary() const;
+};
+
+// Checks planned paths against the geometric shapes (geofences): every path
+// segment is tested for crossing a shape boundary, lying inside a polygon and
+// keeping the minimum clearance from it. Each shape is projected to local
+// meters around its own center, so distances hold for shapes spread over a
+// whole country, and the shapes' degree boxes are put in an R-tree once per
+// setShapes(); a segment is only tested against the shapes whose box, grown
+// by the clearance, it touches.
+//
+// A shape may set its own clearance in meters with a "clearance" property.
+// validate() is const and safe to run from several threads at once.
+class PathValidator
+{
+public:
+    static const double DEFAULT_CLEARANCE_METERS;
+
+    PathValidator();
+
+    void setShapes(const QJsonObject& collection);
+    int shapeCount() const { return m_shapes.size(); }
+
+    void setMinimumClearance(double meters);
+    double minimumClearance() const { return m_minimumClearance; }
+
+    PathValidationResult validate(const QString& droneName, const QJsonObject& pathFeature) const;
+
+    // Validates every path, in parallel on the global thread pool
+    QMap<QString, PathValidationResult> validateFleet(const QMap<QString, QJsonObject>& paths) const;
+
+private:
+    struct PreparedShape {
+        QString id;
+        QString name;
+        double clearance = -1.0;  // below 0 uses the minimum clearance
+        LocalProjection projection;
+        QVector<QVector<QPolygonF>> polygons;
+        QVector<QPolygonF> lines;
+        QVector<QPointF> points;
+    };
+
+    void prepareGeometry(const QJsonObject& geometry, PreparedShape& shape) const;
+    double clearanceOf(const PreparedShape& shape) const;
+    bool checkSegment(const QPointF& a, const QPointF& b, const PreparedShape& shape, PathViolation& violation) const;
+
+    QVector<PreparedShape> m_shapes;
+    SpatialIndex m_index;
+    double m_minimumClearance;
+    // Largest clearance set by a shape, bounds the index query around a segment
+    double m_maximumShapeClearance;
+};
+
+#endif // PATHVALIDATOR_H
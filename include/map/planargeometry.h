@@ -0,0 +1,58 @@
+#ifndef PLANARGEOMETRY_H
+#define PLANARGEOMETRY_H
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QVector>
+#include <QJsonArray>
+
+// Equirectangular projection around an origin, accurate to well under a
+// meter over the few tens of kilometers a mission covers. x points east and
+// y north, both in meters. Data spread wider than that is projected per
+// shape or per segment rather than around one origin.
+class LocalProjection
+{
+public:
+    LocalProjection(double originLng = 0.0, double originLat = 0.0);
+
+    double originLng() const { return m_originLng; }
+    double originLat() const { return m_originLat; }
+
+    QPointF toMeters(double lng, double lat) const;
+    // [lng, lat(, alt)] position
+    QPointF toMeters(const QJsonArray& position) const;
+    void toLngLat(const QPointF& meters, double& lng, double& lat) const;
+
+    // Ring or line of [lng, lat] positions
+    QPolygonF lineToMeters(const QJsonArray& positions) const;
+
+    // Degrees spanning the meters east / north at the origin
+    double lngDegrees(double meters) const { return meters / m_metersPerDegreeLng; }
+    double latDegrees(double meters) const { return meters / m_metersPerDegreeLat; }
+
+private:
+    double m_originLng;
+    double m_originLat;
+    double m_metersPerDegreeLng;
+    double m_metersPerDegreeLat;
+};
+
+// Planar primitives on projected coordinates
+class PlanarGeometry
+{
+public:
+    // [lng, lat] positions as points, unprojected
+    static QPolygonF positionsToPolygon(const QJsonArray& positions);
+
+    static double pointSegmentDistance(const QPointF& p, const QPointF& a, const QPointF& b);
+    static bool segmentsIntersect(const QPointF& a, const QPointF& b, const QPointF& c, const QPointF& d);
+    // 0 when the segments intersect
+    static double segmentDistance(const QPointF& a, const QPointF& b, const QPointF& c, const QPointF& d);
+
+    // Even-odd test over every ring, so holes are excluded
+    static bool ringsContain(const QVector<QPolygonF>& rings, const QPointF& p);
+    // Distance from a segment to the closest edge of the rings
+    static double segmentRingsDistance(const QPointF& a, const QPointF& b, const QVector<QPolygonF>& rings);
+};
+
+#endif // PLANARGEOMETRY_H
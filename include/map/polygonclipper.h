@@ -0,0 +1,43 @@
+#ifndef POLYGONCLIPPER_H
+#define POLYGONCLIPPER_H
+
+#include <QVector>
+#include <QPainterPath>
+#include <QJsonObject>
+#include "planargeometry.h"
+
+// Boolean operations and buffering on GeoJSON Polygon / MultiPolygon
+// geometries, computed by QPainterPath in meters around the inputs' center.
+// The projection is linear in lng / lat, so unions and clips are exact at any
+// extent; only buffer distances depend on it and are meant for local zones.
+//
+// Results are Polygon or MultiPolygon geometries with counter-clockwise
+// outer rings and clockwise holes, or an empty object when no area remains.
+class PolygonClipper
+{
+public:
+    static QJsonObject unite(const QVector<QJsonObject>& geometries);
+    static QJsonObject intersect(const QJsonObject& a, const QJsonObject& b);
+    static QJsonObject subtract(const QJsonObject& geometry, const QVector<QJsonObject>& cutters);
+
+    // Grows polygons by distanceMeters, or shrinks them when it is negative;
+    // points and lines become areas of that half width with round ends
+    static QJsonObject buffer(const QJsonObject& geometry, double distanceMeters);
+
+    // Geometries whose areas overlap, transitively, unioned into one
+    struct MergedGroup {
+        QVector<int> members;  // indexes into the input
+        QJsonObject geometry;
+    };
+
+    // Only groups of two or more geometries are returned; candidates come
+    // from an R-tree over the bounding boxes
+    static QVector<MergedGroup> mergeOverlapping(const QVector<QJsonObject>& geometries);
+
+private:
+    static LocalProjection projectionFor(const QVector<QJsonObject>& geometries);
+    static QPainterPath toPath(const QJsonObject& geometry, const LocalProjection& projection);
+    static QJsonObject toGeometry(const QPainterPath& path, const LocalProjection& projection);
+};
+
+#endif // POLYGONCLIPPER_H
@@ -0,0 +1,149 @@
+#ifndef SHAPESTORE_H
+#define SHAPESTORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include "spatialindex.h"
+
+// In-memory collection of the geometric shapes (geofences), indexed by shape
+// id and by an R-tree over their bounding boxes.
+//
+// Shapes keep the "id" of their feature, shapes without one get a stable
+// generated id. Edits are published on the UpdateBus as ShapeChanges holding
+// only the edited shapes, and appended as one record per shape to
+// geometric_shapes.log. The log is compacted into the binary
+// geometric_shapes.dgb snapshot (see BinaryGeometryFile) once it holds as many
+// records as there are shapes, so an edit costs the same with five or five
+// thousand shapes.
+//
+// Shapes live for one session: clear() drops them and their files on exit.
+// Files found on start are what a crashed or killed session left behind,
+// so the snapshot is read and the log replayed to recover its shapes.
+//
+// geometric_shapes.geojson is only written by exportGeoJson(); when it is
+// newer than the snapshot (edited outside the app) it replaces the shapes.
+//
+// Edits do not rebuild the index: queries test the shapes changed since the
+// last build one by one next to the R-tree, which is rebuilt on the first
+// query after a batch of changes (or a reload). Queries may run on any
+// thread.
+class ShapeStore : public QObject
+{
+    Q_OBJECT
+public:
+    static ShapeStore& instance();
+
+    // Adds or replaces the shape with the feature's id, returns the id
+    QString addShape(const QJsonObject& feature);
+    QStringList addShapes(const QJsonArray& features);
+    // Bulk insert of already parsed shapes with their bounding boxes (see
+    // GeoJsonImporter). Writes one snapshot instead of a log record per
+    // shape; subscribers receive the rendered features when given, so the
+    // map can draw simplified geometry while the store keeps the original.
+    QStringList importShapes(const QVector<QJsonObject>& features, const QVector<BoundingBox>& boxes,
+                             const QVector<QJsonObject>& rendered = QVector<QJsonObject>());
+    bool removeShape(const QString& id);
+    // Removes every shape whose "name" property matches, returns how many
+    int removeShapesNamed(const QString& name);
+
+    // Replace every shape, e.g. with a collection edited on disk
+    void replaceAll(const QJsonObject& collection);
+
+    bool contains(const QString& id) const { return m_shapes.contains(id); }
+    QJsonObject shape(const QString& id) const { return m_shapes.value(id).feature; }
+    QStringList shapeIds() const { return m_shapes.keys(); }
+    int count() const { return m_shapes.size(); }
+
+    // All shapes as a FeatureCollection, rebuilt lazily after changes
+    QJsonObject featureCollection() const;
+
+    // The shapes with overlapping zones unioned (see PolygonClipper), for
+    // consumers that only need the covered area, like the LLM context. Only
+    // zones with the same altitude band and clearance are merged; a merged
+    // zone keeps the id and properties of its first member and lists every
+    // member in "mergedFrom". Rebuilt lazily after changes.
+    QJsonObject mergedCollection() const;
+
+    // Incremented on every change
+    quint64 revision() const { return m_revision; }
+
+    // Ids of the shapes whose bounding box contains the point, intersects
+    // the box or is touched by the segment. Coordinates are lng, lat.
+    QStringList queryPoint(double lng, double lat) const;
+    QStringList queryBox(const BoundingBox& box) const;
+    QStringList querySegment(double lng1, double lat1, double lng2, double lat2) const;
+
+    // Shapes whose polygon contains the point, exact test on top of queryPoint
+    QStringList shapesContaining(double lng, double lat) const;
+
+    // Reread the GeoJSON file, only when it changed since it was last read or
+    // exported by the store. Returns true when shapes were reloaded.
+    bool reloadIfChanged();
+
+    // Drop all shapes and the files backing them
+    void clear();
+
+    // Write the snapshot and truncate the append log
+    bool compact();
+
+    // Every shape as GeoJSON, to geoJsonPath() when no path is given
+    bool exportGeoJson(const QString& path = QString());
+
+    QString snapshotPath() const;
+    QString logPath() const;
+    QString geoJsonPath() const;
+
+private:
+    explicit ShapeStore(QObject* parent = nullptr);
+    ~ShapeStore();
+
+    // Prevent copying
+    ShapeStore(const ShapeStore&) = delete;
+    ShapeStore& operator=(const ShapeStore&) = delete;
+
+    struct Shape {
+        QJsonObject feature;
+        BoundingBox box;
+    };
+
+    // Returns the id the shape is stored under
+    QString insertShape(const QJsonObject& feature, const BoundingBox* box = nullptr);
+    void changed(const QHash<QString, QJsonObject>& upserted, const QStringList& removed);
+    void reset();
+    void appendLogRecords(const QList<QJsonObject>& records);
+    void compactIfNeeded();
+    bool loadSnapshot();
+    void ensureIndex() const;
+    template<typename Predicate>
+    QStringList indexedIds(const QVector<int>& values, Predicate overlaps) const;
+
+    QString m_directory;
+    QHash<QString, Shape> m_shapes;
+    quint64 m_revision;
+    quint64 m_nextId;
+    int m_logRecords;
+    QDateTime m_geoJsonModified;
+
+    mutable QJsonObject m_cachedCollection;
+    mutable quint64 m_cachedRevision;
+    mutable QJsonObject m_mergedCollection;
+    mutable quint64 m_mergedRevision;
+
+    // Index over m_indexedIds, guarded for queries from worker threads.
+    // Shapes added, edited or removed since it was built are in m_changedIds.
+    mutable QMutex m_indexMutex;
+    mutable SpatialIndex m_index;
+    mutable QVector<QString> m_indexedIds;
+    mutable QSet<QString> m_changedIds;
+    mutable bool m_indexStale;
+};
+
+#endif // SHAPESTORE_H
@@ -0,0 +1,81 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <limits>
+
+// Axis aligned box in the coordinate space of the indexed data (longitude,
+// latitude degrees for shapes)
+struct BoundingBox {
+    double minX = std::numeric_limits<double>::max();
+    double minY = std::numeric_limits<double>::max();
+    double maxX = -std::numeric_limits<double>::max();
+    double maxY = -std::numeric_limits<double>::max();
+
+    bool isNull() const { return minX > maxX || minY > maxY; }
+    double centerX() const { return (minX + maxX) / 2.0; }
+    double centerY() const { return (minY + maxY) / 2.0; }
+
+    void expand(double x, double y);
+    void expand(const BoundingBox& other);
+    bool intersects(const BoundingBox& other) const;
+    bool contains(double x, double y) const;
+    // True when the segment from (x1, y1) to (x2, y2) touches the box
+    bool intersectsSegment(double x1, double y1, double x2, double y2) const;
+
+    // Box of every position of a GeoJSON geometry, null for empty geometries
+    static BoundingBox ofGeometry(const QJsonObject& geometry);
+};
+
+// Static R-tree over bounding boxes, bulk loaded with Sort-Tile-Recursive
+// packing: entries are sorted into vertical slices by x, every slice by y,
+// and packed into full nodes, level by level up to the root. Nodes live in
+// flat arrays, queries walk them with an explicit stack.
+//
+// The tree is rebuilt as a whole with build(); it holds no pointers, so
+// copies are cheap (implicitly shared) and const queries are thread safe.
+class SpatialIndex
+{
+public:
+    static const int NODE_CAPACITY = 16;
+
+    struct Entry {
+        BoundingBox box;
+        int value;
+    };
+
+    SpatialIndex();
+
+    void build(QVector<Entry> entries);
+    void clear();
+
+    int size() const { return m_entries.size(); }
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    BoundingBox bounds() const;
+
+    // Values of the entries whose box contains the point, intersects the box
+    // or is touched by the segment
+    QVector<int> queryPoint(double x, double y) const;
+    QVector<int> queryBox(const BoundingBox& box) const;
+    QVector<int> querySegment(double x1, double y1, double x2, double y2) const;
+
+private:
+    struct Node {
+        BoundingBox box;
+        // Range of children, entries for leaves and nodes otherwise
+        int first;
+        int count;
+        bool leaf;
+    };
+
+    template<typename Predicate>
+    QVector<int> query(Predicate overlaps) const;
+
+    QVector<Entry> m_entries;
+    QVector<Node> m_nodes;
+    int m_root;
+};
+
+#endif // SPATIALINDEX_H
@@ -6,6 +6,7 @@
 #include <QVBoxLayout>
 #include <QPushButton>
 #include <QTimer>
+#include "../drone/UpdateBus.h"
 
 class SimulationView : public QWidget {
     Q_OBJECT
@@ -21,8 +22,8 @@ private:
     
     void setupUI();
     void createSimulationHtml();
-    void startPathUpdateTimer();
-    void updateDronePath(const QString& droneName);
+    void subscribeToUpdates();
+    void updateDronePath(PathSnapshotPtr snapshot);
 };
 
 #endif // SIMULATIONVIEW_H 
\ No newline at end of file
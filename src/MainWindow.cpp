@@ -11,6 +11,8 @@
 #include <QDockWidget>
 #include <QStatusBar>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QFileInfo>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -54,16 +56,65 @@ MainWindow::MainWindow(QWidget *parent)
     // Connect right sidebar task assignment signal
     connect(rightSidebar, &RightSidebar::assignTask, this, &MainWindow::handleRightSidebarTaskAssignment);
     
+    // Import geofences from a file, the import runs on a worker thread
+    connect(topBar, &TopBar::importShapesRequested, this, &MainWindow::handleImportShapes);
+    connect(mapViewer, &MapViewer::importProgress, this,
+            [this](qint64 bytesRead, qint64 totalBytes, int features) {
+                const int percent = totalBytes > 0 ? int(bytesRead * 100 / totalBytes) : 0;
+                statusBar()->showMessage(QString("Importing shapes: %1% (%2 features)").arg(percent).arg(features));
+            });
+    connect(mapViewer, &MapViewer::importFinished, this,
+            [this](int features, const QString& error) {
+                if (error.isEmpty()) {
+                    statusBar()->showMessage(QString("Imported %1 shapes").arg(features), 5000);
+                } else {
+                    QMessageBox::warning(this, "Import Error", "Failed to import shapes: " + error);
+                }
+            });
+    
     // Connect ChatGPT response signal to update the right sidebar
     connect(&ChatGPTClient::instance(), &ChatGPTClient::responseReceived, 
             [this](int missionId, const QString& response, const QString& functions) {
-                // Update status bar with success message
-                statusBar()->showMessage("Mission data received successfully", 3000);
+                // Update status bar with success message, and what the paths conflict with
+                if (missionAdvisories.isEmpty()) {
+                    statusBar()->showMessage("Mission data received successfully", 3000);
+                } else {
+                    statusBar()->showMessage("Mission data received: " + missionAdvisories.join("; "), 10000);
+                    missionAdvisories.clear();
+                }
+            });
+    
+    // Geofence violations and corridor conflicts of received paths are
+    // advisories, not errors
+    connect(&ChatGPTClient::instance(), &ChatGPTClient::pathViolationsFound,
+            [this](const QString& droneName, const QJsonArray& violations) {
+                missionAdvisories.append(QString("%1 crosses %2 geofence(s)").arg(droneName).arg(violations.size()));
+            });
+    connect(&ChatGPTClient::instance(), &ChatGPTClient::corridorConflictsFound,
+            [this](const QString& droneName, const QJsonArray& conflicts) {
+                QStringList drones;
+                for (const QJsonValue& conflict : conflicts) {
+                    const QString other = conflict.toObject().value("id").toString();
+                    if (!drones.contains(other)) {
+                        drones.append(other);
+                    }
+                }
+                missionAdvisories.append(QString("%1 comes too close to %2").arg(droneName, drones.join(", ")));
+            });
+    
+    // Live corridor conflicts of the fleet
+    connect(mapViewer, &MapViewer::corridorConflictsChanged,
+            [this](const QString& droneName, const QJsonArray& conflicts) {
+                if (!conflicts.isEmpty()) {
+                    statusBar()->showMessage(QString("%1 is too close to %2 zone(s) or corridor(s)")
+                                                 .arg(droneName).arg(conflicts.size()), 5000);
+                }
             });
     
     // Connect ChatGPT error signal
     connect(&ChatGPTClient::instance(), &ChatGPTClient::errorOccurred,
             [this](const QString& errorMessage) {
+                missionAdvisories.clear();
                 QMessageBox::warning(this, "API Error", "Error processing mission: " + errorMessage);
             });
 }
@@ -170,6 +221,22 @@ void MainWindow::handleDroneAnimationCompleted()
     // TO DO: implement handling for drone animation completion
 }
 
+void MainWindow::handleImportShapes()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, "Import Geometric Shapes", QString(),
+                                                    "GeoJSON (*.geojson *.json *.geojsons *.geojsonl *.ndjson);;All Files (*)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    // Features without a name are named after the file
+    if (!mapViewer->importGeometricShapes(filePath, QFileInfo(filePath).completeBaseName())) {
+        statusBar()->showMessage("Another import is still running", 3000);
+        return;
+    }
+    statusBar()->showMessage("Importing shapes from " + QFileInfo(filePath).fileName());
+}
+
 void MainWindow::handleRightSidebarTaskAssignment(const QString& missionType, const QString& vehicle, const QString& prompt)
 {
     // Show status message
@@ -1,5 +1,8 @@
 #include "../../include/api/ChatGPTClient.h"
 #include "../../include/database/DatabaseManager.h"
+#include "../../include/drone/FleetPathStore.h"
+#include "../../include/drone/UpdateBus.h"
+#include "../../include/map/shapestore.h"
 #include <QUrlQuery>
 #include <QNetworkRequest>
 #include <QDebug>
@@ -9,6 +12,22 @@
 #include <QCoreApplication>
 #include <QJsonDocument>
 #include <QFileInfo>
+#include <QTimer>
+#include <QRandomGenerator>
+#include <QMap>
+#include <limits>
+
+namespace {
+// Timeouts used until a backend has enough latency samples
+const int DEFAULT_TIMEOUT_MS = 90000;
+const int MIN_TIMEOUT_MS = 15000;
+const int MAX_TIMEOUT_MS = 180000;
+const int MIN_LATENCY_SAMPLES = 5;
+
+// Retry backoff for transient errors
+const int BACKOFF_BASE_MS = 1000;
+const int BACKOFF_MAX_MS = 30000;
+}
 
 QString loadApiKey() {
     // Direct path to .profile file
@@ -40,8 +59,11 @@ ChatGPTClient& ChatGPTClient::instance()
 }
 
 ChatGPTClient::ChatGPTClient(QObject* parent)
-    : QObject(parent), networkManager(new QNetworkAccessManager(this)), currentMissionId(-1)
+    : QObject(parent), networkManager(new QNetworkAccessManager(this)), nextRequestId(1),
+      hedgingEnabled(true), maxRetries(3),
+      validatorShapesRevision(std::numeric_limits<quint64>::max())
 {
+    clock.start();
     connect(networkManager, &QNetworkAccessManager::finished, this, &ChatGPTClient::handleNetworkReply);
     apiKey = loadApiKey();
     
@@ -55,12 +77,31 @@ ChatGPTClient::~ChatGPTClient()
 }
 
 void ChatGPTClient::sendPrompt(const QString& missionType, const QString& vehicle, const QString& prompt)
+{
+    dispatchPrompt(missionType, QStringList{vehicle}, prompt, false);
+}
+
+void ChatGPTClient::sendFleetPrompt(const QString& missionType, const QStringList& vehicles, const QString& prompt)
+{
+    if (vehicles.isEmpty()) {
+        emit errorOccurred("No vehicles selected for fleet mission.");
+        return;
+    }
+
+    // A single vehicle does not need the fleet format
+    dispatchPrompt(missionType, vehicles, prompt, vehicles.size() > 1);
+}
+
+void ChatGPTClient::dispatchPrompt(const QString& missionType, const QStringList& vehicles,
+                                   const QString& prompt, bool fleet)
 {
     if (apiKey.isEmpty()) {
         emit errorOccurred("API key is empty. Please check .profile file");
         return;
     }
 
+    QString vehicle = vehicles.join(", ");
+
     // Save mission data to database first
     if (!DatabaseManager::instance().saveMissionData(missionType, vehicle, prompt)) {
         emit errorOccurred("Failed to save mission data to database.");
@@ -68,10 +109,11 @@ void ChatGPTClient::sendPrompt(const QString& missionType, const QString& vehicl
     }
     
     // Get the last inserted mission ID
+    int missionId = -1;
     QSqlQuery query;
     query.exec("SELECT last_insert_rowid()");
     if (query.next()) {
-        currentMissionId = query.value(0).toInt();
+        missionId = query.value(0).toInt();
     } else {
         emit errorOccurred("Failed to retrieve mission ID.");
         return;
@@ -97,7 +139,42 @@ void ChatGPTClient::sendPrompt(const QString& missionType, const QString& vehicl
     // System message with GeoJSON format instructions
     QJsonObject systemMessage;
     systemMessage["role"] = "system";
-    systemMessage["content"] = R"(
+    systemMessage["content"] = fleet ? fleetPathInstructions() : singlePathInstructions();
+    messages.append(systemMessage);
+    
+    // Add geometric shapes context message
+    QJsonObject geometricShapesMessage;
+    geometricShapesMessage["role"] = "system";
+    geometricShapesMessage["content"] = QString("The following geometric shapes are present in the area. Consider these when planning the drone path:\n%1")
+                                        .arg(QString(QJsonDocument(geometricShapesData).toJson(QJsonDocument::Indented)));
+    messages.append(geometricShapesMessage);
+    
+    // User message with mission details
+    QJsonObject userMessage;
+    userMessage["role"] = "user";
+    userMessage["content"] = QString("Mission Type: %1\n%2: %3\nPrompt: %4")
+                            .arg(missionType, fleet ? "Vehicles" : "Vehicle", vehicle, prompt);
+    messages.append(userMessage);
+    
+    payload["messages"] = messages;
+    
+    // Send the request
+    PendingRequest pending;
+    pending.missionId = missionId;
+    pending.vehicles = vehicles;
+    pending.fleet = fleet;
+    pending.backend = QString("%1/%2").arg(request.url().host(), payload["model"].toString());
+    pending.request = request;
+    pending.body = QJsonDocument(payload).toJson();
+
+    int requestId = nextRequestId++;
+    pendingRequests.insert(requestId, pending);
+    startAttempt(requestId);
+}
+
+QString ChatGPTClient::singlePathInstructions()
+{
+    return R"(
 Generate a strictly formatted GeoJSON Feature defining a drone flight path that will be added to a FeatureCollection.
 
 GeoJSON Format (Strict Rules)
@@ -154,121 +231,327 @@ Keep the response strictly in this format every time. No variations.
 - GeoJSON is strictly typed; ensure that types (such as "Feature", "LineString") are specified verbatim.
 - Name each feature clearly to reflect the mission or surveillance areas they cover.
 - Include the drone name in the properties.)";
-    messages.append(systemMessage);
-    
-    // Add geometric shapes context message
-    QJsonObject geometricShapesMessage;
-    geometricShapesMessage["role"] = "system";
-    geometricShapesMessage["content"] = QString("The following geometric shapes are present in the area. Consider these when planning the drone path:\n%1")
-                                        .arg(QString(QJsonDocument(geometricShapesData).toJson(QJsonDocument::Indented)));
-    messages.append(geometricShapesMessage);
-    
-    // User message with mission details
-    QJsonObject userMessage;
-    userMessage["role"] = "user";
-    userMessage["content"] = QString("Mission Type: %1\nVehicle: %2\nPrompt: %3")
-                            .arg(missionType, vehicle, prompt);
-    messages.append(userMessage);
-    
-    payload["messages"] = messages;
-    
-    // Send the request
-    QJsonDocument doc(payload);
-    networkManager->post(request, doc.toJson());
 }
 
-QJsonObject ChatGPTClient::loadGeometricShapesData()
+QString ChatGPTClient::fleetPathInstructions()
 {
-    // Get application path
-    QString geojsonDir = QDir::currentPath() + "/drone_geojson";
-    
-    // Path to the geometric shapes file
-    QString shapesFilename = geojsonDir + "/geometric_shapes.geojson";
-    QFileInfo fileInfo(shapesFilename);
-    
-    // Create empty GeoJSON object as default
-    QJsonObject emptyGeoJson;
-    emptyGeoJson["type"] = "FeatureCollection";
-    emptyGeoJson["features"] = QJsonArray();
-    
-    // Check if file exists
-    if (!fileInfo.exists()) {
-        qDebug() << "Geometric shapes file does not exist, creating empty one for API call";
-        
-        // Ensure directory exists
-        QDir dir(geojsonDir);
-        if (!dir.exists()) {
-            dir.mkpath(".");
-        }
-        
-        // Create empty file
-        QFile file(shapesFilename);
-        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QJsonDocument doc(emptyGeoJson);
-            file.write(doc.toJson());
-            file.close();
-        }
-        
-        return emptyGeoJson;
+    return R"(
+Generate a strictly formatted GeoJSON FeatureCollection defining one flight path for each drone listed in the user message.
+
+GeoJSON Format (Strict Rules)
+You must return a single FeatureCollection object with:
+
+"type": "FeatureCollection"
+
+"features": exactly one Feature per listed drone, each with:
+
+"type": "Feature"
+
+"properties": { 
+  "name": "[Mission Name]",
+  "drone": "[Drone Name]",
+  "type": "path"
+}
+
+"geometry":
+
+"type": "LineString"
+
+"coordinates": Array of [longitude, latitude] pairs
+
+Constraints of three drone placed 10 meters apart. start each path with the base location of its drone
+Base Location of Atlas: [77.9695, 10.3624]
+Base Location of Bolt: [77.9695, 10.36249]
+Base Location of Barbarian: [77.96961, 10.3624]
+
+At least 3 waypoints forming each "LineString"
+
+Correct coordinate order: [longitude, latitude]
+
+Paths of different drones must not cross each other at the same time
+
+No extra properties or null values
+
+Example Output:
+{
+  "type": "FeatureCollection",
+  "features": [
+    {
+      "type": "Feature",
+      "properties": {
+        "name": "Perimeter Sweep North",
+        "drone": "Atlas",
+        "type": "path"
+      },
+      "geometry": {
+        "type": "LineString",
+        "coordinates": [
+          [77.9695, 10.3624],
+          [77.9700, 10.3628],
+          [77.9702, 10.3632]
+        ]
+      }
+    },
+    {
+      "type": "Feature",
+      "properties": {
+        "name": "Perimeter Sweep South",
+        "drone": "Bolt",
+        "type": "path"
+      },
+      "geometry": {
+        "type": "LineString",
+        "coordinates": [
+          [77.9695, 10.36249],
+          [77.9690, 10.3620],
+          [77.9688, 10.3616]
+        ]
+      }
     }
-    
-    // File exists, read it
-    QFile file(shapesFilename);
-    if (file.open(QIODevice::ReadOnly)) {
-        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-        file.close();
-        
-        if (!doc.isNull() && doc.isObject()) {
-            qDebug() << "Successfully loaded geometric shapes data for API call";
-            return doc.object();
-        }
+  ]
+}
+
+Keep the response strictly in this format every time. No variations.
+# Notes
+- Don't add comments in geojson data. 
+- Give Code geojson data code alone.
+- Ensure that coordinate values are accurate and appropriate for the designated flight region.
+- GeoJSON is strictly typed; ensure that types (such as "FeatureCollection", "Feature", "LineString") are specified verbatim.
+- Name each feature clearly to reflect the mission or surveillance areas they cover.
+- Use the exact drone names from the user message in the "drone" property.)";
+}
+
+void ChatGPTClient::startAttempt(int requestId)
+{
+    auto it = pendingRequests.find(requestId);
+    if (it == pendingRequests.end()) {
+        return;
+    }
+
+    PendingRequest& pending = it.value();
+    pending.attempt++;
+    pending.hedged = false;
+    pending.attemptStartTime = clock.elapsed();
+    pending.timeoutMs = attemptTimeoutMs(pending.backend);
+    postReply(requestId);
+
+    int attempt = pending.attempt;
+    QTimer::singleShot(pending.timeoutMs, this, [this, requestId, attempt]() {
+        handleAttemptTimeout(requestId, attempt);
+    });
+
+    int hedgeDelay = hedgeDelayMs(pending.backend);
+    if (hedgingEnabled && hedgeDelay > 0) {
+        QTimer::singleShot(hedgeDelay, this, [this, requestId, attempt]() {
+            fireHedge(requestId, attempt);
+        });
+    }
+}
+
+QNetworkReply* ChatGPTClient::postReply(int requestId)
+{
+    PendingRequest& pending = pendingRequests[requestId];
+    QNetworkReply* reply = networkManager->post(pending.request, pending.body);
+    pending.replies.append(reply);
+    replyRequests.insert(reply, requestId);
+    return reply;
+}
+
+void ChatGPTClient::fireHedge(int requestId, int attempt)
+{
+    auto it = pendingRequests.find(requestId);
+    if (it == pendingRequests.end() || it->attempt != attempt || it->hedged || it->replies.isEmpty()) {
+        return;
+    }
+
+    // The first request is slower than p95: race a second one and keep the winner
+    qDebug() << "Hedging planner request" << requestId << "on" << it->backend;
+    it->hedged = true;
+    postReply(requestId);
+}
+
+void ChatGPTClient::handleAttemptTimeout(int requestId, int attempt)
+{
+    auto it = pendingRequests.find(requestId);
+    if (it == pendingRequests.end() || it->attempt != attempt) {
+        return;
+    }
+
+    qDebug() << "Planner request" << requestId << "timed out after" << it->timeoutMs << "ms";
+
+    // A timeout counts as a sample at the timeout, so a backend that slowed
+    // down pushes p95 and with it the next attempt's timeout up
+    latencyHistograms[it->backend].record(it->timeoutMs);
+    abortReplies(it.value());
+    retryOrFail(requestId, "request timed out");
+}
+
+void ChatGPTClient::abortReplies(PendingRequest& pending)
+{
+    // Forget the replies first so their finished() signals are ignored
+    QList<QNetworkReply*> replies = pending.replies;
+    pending.replies.clear();
+    for (QNetworkReply* reply : replies) {
+        replyRequests.remove(reply);
+        reply->abort();
+    }
+}
+
+void ChatGPTClient::retryOrFail(int requestId, const QString& reason)
+{
+    auto it = pendingRequests.find(requestId);
+    if (it == pendingRequests.end()) {
+        return;
+    }
+
+    if (it->attempt > maxRetries) {
+        pendingRequests.erase(it);
+        emit errorOccurred(QString("Network error: %1").arg(reason));
+        return;
+    }
+
+    // Exponential backoff with jitter so retries from several requests do not align
+    int backoff = qMin(BACKOFF_MAX_MS, BACKOFF_BASE_MS << qMin(it->attempt - 1, 10));
+    int delay = backoff / 2 + QRandomGenerator::global()->bounded(backoff / 2 + 1);
+    qDebug() << "Retrying planner request" << requestId << "in" << delay << "ms:" << reason;
+
+    QTimer::singleShot(delay, this, [this, requestId]() {
+        startAttempt(requestId);
+    });
+}
+
+bool ChatGPTClient::isTransientError(QNetworkReply* reply) const
+{
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 429 || status == 500 || status == 502 || status == 503 || status == 504) {
+        return true;
+    }
+
+    switch (reply->error()) {
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::HostNotFoundError:
+        case QNetworkReply::ProxyTimeoutError:
+        case QNetworkReply::InternalServerError:
+        case QNetworkReply::ServiceUnavailableError:
+        case QNetworkReply::UnknownServerError:
+            return true;
+        default:
+            return false;
     }
-    
-    // If we couldn't read the file or it was invalid, return empty GeoJSON
-    qDebug() << "Failed to read geometric shapes file, using empty data for API call";
-    return emptyGeoJson;
+}
+
+int ChatGPTClient::attemptTimeoutMs(const QString& backend) const
+{
+    LatencyHistogram histogram = latencyHistograms.value(backend);
+    if (histogram.sampleCount() < MIN_LATENCY_SAMPLES) {
+        return DEFAULT_TIMEOUT_MS;
+    }
+
+    // Allow twice the observed p95 before giving up on an attempt
+    qint64 p95 = histogram.percentile(0.95);
+    return int(qBound<qint64>(MIN_TIMEOUT_MS, p95 * 2, MAX_TIMEOUT_MS));
+}
+
+int ChatGPTClient::hedgeDelayMs(const QString& backend) const
+{
+    LatencyHistogram histogram = latencyHistograms.value(backend);
+    if (histogram.sampleCount() < MIN_LATENCY_SAMPLES) {
+        return -1;
+    }
+    return int(histogram.percentile(0.95));
+}
+
+QJsonObject ChatGPTClient::loadGeometricShapesData()
+{
+    // Shapes are held in memory by the store, no file is read. Overlapping
+    // zones are sent as one, the model only needs the area to avoid
+    return ShapeStore::instance().mergedCollection();
 }
 
 void ChatGPTClient::handleNetworkReply(QNetworkReply* reply)
 {
+    reply->deleteLater();
+
+    // Replies of finished, timed out or hedged-out requests are ignored
+    if (!replyRequests.contains(reply)) {
+        return;
+    }
+
+    int requestId = replyRequests.take(reply);
+    PendingRequest& pending = pendingRequests[requestId];
+    pending.replies.removeAll(reply);
+
     if (reply->error() != QNetworkReply::NoError) {
-        emit errorOccurred(QString("Network error: %1").arg(reply->errorString()));
-        reply->deleteLater();
+        qDebug() << "Planner request" << requestId << "failed:" << reply->errorString();
+
+        // Another hedged reply is still in flight, let it finish
+        if (!pending.replies.isEmpty()) {
+            return;
+        }
+
+        if (isTransientError(reply)) {
+            retryOrFail(requestId, reply->errorString());
+        } else {
+            pendingRequests.remove(requestId);
+            emit errorOccurred(QString("Network error: %1").arg(reply->errorString()));
+        }
         return;
     }
-    
-    QByteArray responseData = reply->readAll();
-    
+
+    // First successful reply wins, drop any hedged duplicates. Latency runs
+    // from the attempt start, a hedge winner's own start would bias p95 down
+    latencyHistograms[pending.backend].record(clock.elapsed() - pending.attemptStartTime);
+    abortReplies(pending);
+    PendingRequest finished = pendingRequests.take(requestId);
+
+    if (finished.fleet) {
+        processFleetResponse(finished.missionId, finished.vehicles, reply->readAll());
+    } else {
+        processResponse(finished.missionId, reply->readAll());
+    }
+}
+
+bool ChatGPTClient::extractContent(const QByteArray& responseData, QString& content)
+{
     QJsonDocument doc = QJsonDocument::fromJson(responseData);
     
     if (doc.isNull() || !doc.isObject()) {
         emit errorOccurred("Invalid response format from API");
-        reply->deleteLater();
-        return;
+        return false;
     }
     
     QJsonObject responseObj = doc.object();
     
     if (!responseObj.contains("choices") || !responseObj["choices"].isArray()) {
         emit errorOccurred("No choices in API response");
-        reply->deleteLater();
-        return;
+        return false;
     }
     
     QJsonArray choices = responseObj["choices"].toArray();
     if (choices.isEmpty()) {
         emit errorOccurred("Empty choices array in API response");
-        reply->deleteLater();
-        return;
+        return false;
     }
     
     QJsonObject messageObj = choices[0].toObject()["message"].toObject();
-    QString content = messageObj["content"].toString();
+    content = messageObj["content"].toString();
     
     // Validate response
     if (content.isEmpty()) {
         emit errorOccurred("Empty response from API");
-        reply->deleteLater();
+        return false;
+    }
+    return true;
+}
+
+void ChatGPTClient::processResponse(int missionId, const QByteArray& responseData)
+{
+    QString content;
+    if (!extractContent(responseData, content)) {
         return;
     }
     
@@ -276,33 +559,151 @@ void ChatGPTClient::handleNetworkReply(QNetworkReply* reply)
     QJsonDocument featureDoc = QJsonDocument::fromJson(content.toUtf8());
     if (featureDoc.isNull() || !featureDoc.isObject()) {
         emit errorOccurred("Invalid GeoJSON format in response");
-        reply->deleteLater();
         return;
     }
     
     // Get the Feature object
     QJsonObject feature = featureDoc.object();
+    if (!isValidPathFeature(feature)) {
+        emit errorOccurred("Invalid path geometry in response");
+        return;
+    }
     
     // Extract mission details from the GeoJSON properties
     QJsonObject properties = feature.value("properties").toObject();
     QString missionTitle = properties.value("name").toString();
     
-    // Setup paths
-    QString appPath = QCoreApplication::applicationDirPath();
-    QString geojsonDir = appPath + "/drone_geojson";
+    QString vehicleName = "drone";
+    missionId = updateMissionDetails(missionId, missionTitle, vehicleName);
+    
+    // Check the path against the geofences before it is shown
+    QMap<QString, QJsonObject> paths;
+    paths.insert(vehicleName, feature);
+    applyValidation(feature, validatePaths(paths).value(vehicleName));
+    applyCorridorConflicts(feature, vehicleName, checkCorridors(paths).value(vehicleName));
     
-    // Ensure directory exists
-    QDir dir(geojsonDir);
-    if (!dir.exists()) {
-        dir.mkpath(".");
+    storeDronePath(vehicleName, feature);
+    
+    // Save response to database
+    if (missionId > 0) {
+        if (!DatabaseManager::instance().saveChatGPTResponse(missionId, content, "{}")) {
+            emit errorOccurred("Failed to save response to database");
+            return;
+        }
     }
     
+    // Emit signal with response
+    emit responseReceived(missionId, content, "{}");
+}
+
+void ChatGPTClient::processFleetResponse(int missionId, const QStringList& vehicles, const QByteArray& responseData)
+{
+    QString content;
+    if (!extractContent(responseData, content)) {
+        return;
+    }
+    
+    // Parse the GeoJSON content (which should be a FeatureCollection)
+    QJsonDocument collectionDoc = QJsonDocument::fromJson(content.toUtf8());
+    QJsonObject collection = collectionDoc.object();
+    if (collectionDoc.isNull() || !collectionDoc.isObject() ||
+        collection.value("type").toString() != "FeatureCollection" || !collection.value("features").isArray()) {
+        emit errorOccurred("Invalid GeoJSON FeatureCollection in fleet response");
+        return;
+    }
+    
+    // Validate every feature and split them per drone in a single pass
+    QMap<QString, QJsonObject> dronePaths;
+    const QJsonArray features = collection.value("features").toArray();
+    for (const QJsonValue& value : features) {
+        QJsonObject feature = value.toObject();
+        QString droneName = feature.value("properties").toObject().value("drone").toString();
+        
+        if (!vehicles.contains(droneName)) {
+            emit errorOccurred(QString("Fleet response contains a path for unknown drone: %1").arg(droneName));
+            return;
+        }
+        if (dronePaths.contains(droneName)) {
+            emit errorOccurred(QString("Fleet response contains more than one path for drone: %1").arg(droneName));
+            return;
+        }
+        if (!isValidPathFeature(feature)) {
+            emit errorOccurred(QString("Invalid path geometry for drone: %1").arg(droneName));
+            return;
+        }
+        dronePaths.insert(droneName, feature);
+    }
+    
+    for (const QString& vehicle : vehicles) {
+        if (!dronePaths.contains(vehicle)) {
+            emit errorOccurred(QString("Fleet response is missing a path for drone: %1").arg(vehicle));
+            return;
+        }
+    }
+    
+    // The mission title comes from the first path, the vehicle list is kept as stored
+    QString missionTitle = features.first().toObject().value("properties").toObject().value("name").toString();
+    QString vehicleNames;
+    missionId = updateMissionDetails(missionId, missionTitle, vehicleNames);
+    
+    // Check every path against the geofences before they are shown
+    const QMap<QString, PathValidationResult> validations = validatePaths(dronePaths);
+    const QMap<QString, QVector<CorridorConflict>> corridorConflicts = checkCorridors(dronePaths);
+    for (auto it = dronePaths.begin(); it != dronePaths.end(); ++it) {
+        applyValidation(it.value(), validations.value(it.key()));
+        applyCorridorConflicts(it.value(), it.key(), corridorConflicts.value(it.key()));
+        storeDronePath(it.key(), it.value());
+    }
+    
+    // Save response to database
+    if (missionId > 0) {
+        if (!DatabaseManager::instance().saveChatGPTResponse(missionId, content, "{}")) {
+            emit errorOccurred("Failed to save response to database");
+            return;
+        }
+    }
+    
+    // Emit signal with response
+    emit responseReceived(missionId, content, "{}");
+}
+
+bool ChatGPTClient::isValidPathFeature(const QJsonObject& feature)
+{
+    if (feature.value("type").toString() != "Feature") {
+        return false;
+    }
+    
+    QJsonObject geometry = feature.value("geometry").toObject();
+    if (geometry.value("type").toString() != "LineString") {
+        return false;
+    }
+    
+    // At least 3 [longitude, latitude] pairs
+    QJsonArray coordinates = geometry.value("coordinates").toArray();
+    if (coordinates.size() < 3) {
+        return false;
+    }
+    for (const QJsonValue& coordinate : coordinates) {
+        QJsonArray point = coordinate.toArray();
+        if (point.size() < 2 || !point[0].isDouble() || !point[1].isDouble()) {
+            return false;
+        }
+        double lng = point[0].toDouble();
+        double lat = point[1].toDouble();
+        if (lng < -180.0 || lng > 180.0 || lat < -90.0 || lat > 90.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int ChatGPTClient::updateMissionDetails(int missionId, const QString& missionTitle, QString& vehicleName)
+{
     // Get vehicle name and mission type from database
     QSqlQuery query;
     query.prepare("SELECT mission_type, vehicle, prompt FROM missions WHERE id = ?");
-    query.addBindValue(currentMissionId);
+    query.addBindValue(missionId);
     QString missionType = "";
-    QString vehicleName = "drone";
     QString prompt = "";
     if (query.exec() && query.next()) {
         missionType = query.value(0).toString();
@@ -323,11 +724,11 @@ void ChatGPTClient::handleNetworkReply(QNetworkReply* reply)
     }
     
     // Update mission data with enhanced information
-    if (currentMissionId > 0) {
+    if (missionId > 0) {
         // First delete the existing record
         QSqlQuery deleteQuery;
         deleteQuery.prepare("DELETE FROM missions WHERE id = ?");
-        deleteQuery.addBindValue(currentMissionId);
+        deleteQuery.addBindValue(missionId);
         deleteQuery.exec();
         
         // Then save the enhanced data
@@ -339,13 +740,18 @@ void ChatGPTClient::handleNetworkReply(QNetworkReply* reply)
             QSqlQuery newIdQuery;
             newIdQuery.exec("SELECT last_insert_rowid()");
             if (newIdQuery.next()) {
-                currentMissionId = newIdQuery.value(0).toInt();
-                qDebug() << "Updated mission with enhanced data. New ID:" << currentMissionId;
+                missionId = newIdQuery.value(0).toInt();
+                qDebug() << "Updated mission with enhanced data. New ID:" << missionId;
             }
         }
     }
-    
+    return missionId;
+}
+
+void ChatGPTClient::storeDronePath(const QString& vehicleName, QJsonObject feature)
+{
     // Add the drone name and color to properties
+    QJsonObject properties = feature.value("properties").toObject();
     properties["name"] = vehicleName;
     properties["type"] = "path";
     
@@ -370,93 +776,87 @@ void ChatGPTClient::handleNetworkReply(QNetworkReply* reply)
     properties["active"] = true;
     feature["properties"] = properties;
     
-    // Main GeoJSON file path
-    QString mainFilename = QString("%1/all_drone_paths.geojson").arg(geojsonDir);
-    
-    // Create or load the main FeatureCollection file
-    QJsonObject mainGeoJson;
-    QFile mainFile(mainFilename);
-    
-    if (mainFile.exists() && mainFile.open(QIODevice::ReadOnly)) {
-        // File exists, read and parse it
-        QJsonDocument existingDoc = QJsonDocument::fromJson(mainFile.readAll());
-        mainFile.close();
-        
-        if (!existingDoc.isNull() && existingDoc.isObject()) {
-            mainGeoJson = existingDoc.object();
-        } else {
-            // Invalid existing file, create new structure
-            mainGeoJson["type"] = "FeatureCollection";
-            mainGeoJson["features"] = QJsonArray();
+    // Replace this drone's entry, only its own path is written to disk
+    FleetPathStore::instance().replacePath(vehicleName, feature);
+}
+
+QMap<QString, PathValidationResult> ChatGPTClient::validatePaths(const QMap<QString, QJsonObject>& paths)
+{
+    // Shapes are only prepared again after they changed
+    ShapeStore& shapes = ShapeStore::instance();
+    if (validatorShapesRevision != shapes.revision()) {
+        pathValidator.setShapes(shapes.featureCollection());
+        validatorShapesRevision = shapes.revision();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QMap<QString, PathValidationResult> results = pathValidator.validateFleet(paths);
+    qDebug() << "Validated" << paths.size() << "paths against" << pathValidator.shapeCount()
+             << "shapes in" << timer.elapsed() << "ms";
+    return results;
+}
+
+void ChatGPTClient::applyValidation(QJsonObject& feature, const PathValidationResult& validation)
+{
+    QJsonObject properties = feature.value("properties").toObject();
+    properties["geofenceValid"] = validation.isValid();
+    properties["geofenceViolations"] = validation.violationsJson();
+    feature["properties"] = properties;
+
+    // An advisory, the path is still saved and shown
+    if (!validation.isValid()) {
+        qDebug() << "Path for" << validation.droneName << "violates geofences:" << validation.summary();
+        emit pathViolationsFound(validation.droneName, validation.violationsJson());
+    }
+}
+
+QMap<QString, QVector<CorridorConflict>> ChatGPTClient::checkCorridors(const QMap<QString, QJsonObject>& paths)
+{
+    // Other drones keep the paths they already fly, the new ones replace theirs
+    FleetPathStore& store = FleetPathStore::instance();
+    for (const QString& droneName : corridorIndex.droneNames()) {
+        if (!store.contains(droneName) && !paths.contains(droneName)) {
+            corridorIndex.removeCorridor(droneName);
         }
-    } else {
-        // File doesn't exist or couldn't be opened, create new structure
-        mainGeoJson["type"] = "FeatureCollection";
-        mainGeoJson["features"] = QJsonArray();
     }
-    
-    // Add the new feature to the features array
-    QJsonArray features;
-    if (mainGeoJson.contains("features") && mainGeoJson["features"].isArray()) {
-        features = mainGeoJson["features"].toArray();
-        
-        // Check if there's already a feature for this drone and remove it
-        for (int i = features.size() - 1; i >= 0; i--) {
-            QJsonObject existingFeature = features[i].toObject();
-            if (existingFeature.contains("properties") && existingFeature["properties"].isObject()) {
-                QJsonObject existingProps = existingFeature["properties"].toObject();
-                if (existingProps.contains("name") && existingProps["name"].toString() == vehicleName) {
-                    // Remove the existing feature for this drone
-                    features.removeAt(i);
-                    qDebug() << "Removed existing path for drone:" << vehicleName;
-                }
-            }
+    for (const QString& droneName : store.droneNames()) {
+        if (!paths.contains(droneName)) {
+            const QJsonObject feature = store.path(droneName);
+            corridorIndex.setCorridor(droneName, feature, CorridorIndex::uncertaintyOf(feature));
         }
     }
-    
-    // Add the new feature
-    features.append(feature);
-    mainGeoJson["features"] = features;
-    
-    // Save the updated FeatureCollection to the main file
-    if (mainFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&mainFile);
-        QJsonDocument mainDoc(mainGeoJson);
-        out << mainDoc.toJson(QJsonDocument::Indented);
-        mainFile.close();
-        qDebug() << "Updated main GeoJSON file with new feature for drone:" << vehicleName;
-    } else {
-        emit errorOccurred(QString("Failed to save main GeoJSON file: %1").arg(mainFile.errorString()));
-    }
-    
-    // Also save to individual file for backward compatibility
-    QString individualFilename = QString("%1/%2_path.geojson").arg(geojsonDir, vehicleName);
-    QFile individualFile(individualFilename);
-    if (individualFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        // Create a FeatureCollection with just this feature
-        QJsonObject singleDroneGeoJson;
-        singleDroneGeoJson["type"] = "FeatureCollection";
-        QJsonArray singleFeatureArray;
-        singleFeatureArray.append(feature);
-        singleDroneGeoJson["features"] = singleFeatureArray;
-        
-        QTextStream out(&individualFile);
-        QJsonDocument singleDoc(singleDroneGeoJson);
-        out << singleDoc.toJson(QJsonDocument::Indented);
-        individualFile.close();
+    for (auto it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        corridorIndex.setCorridor(it.key(), it.value(), CorridorIndex::uncertaintyOf(it.value()));
     }
-    
-    // Save response to database
-    if (currentMissionId > 0) {
-        if (!DatabaseManager::instance().saveChatGPTResponse(currentMissionId, content, "{}")) {
-            emit errorOccurred("Failed to save response to database");
-            reply->deleteLater();
-            return;
+
+    // Zones are covered by the geofence check, only corridors are compared
+    QMap<QString, QVector<CorridorConflict>> results;
+    for (auto it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        results.insert(it.key(), corridorIndex.conflicts(it.key(), 0, false, true));
+    }
+    return results;
+}
+
+void ChatGPTClient::applyCorridorConflicts(QJsonObject& feature, const QString& droneName,
+                                           const QVector<CorridorConflict>& conflicts)
+{
+    QJsonArray json;
+    QStringList drones;
+    for (const CorridorConflict& conflict : conflicts) {
+        json.append(conflict.toJson());
+        if (!drones.contains(conflict.otherId)) {
+            drones.append(conflict.otherId);
         }
     }
-    
-    // Emit signal with response
-    emit responseReceived(currentMissionId, content, "{}");
-    
-    reply->deleteLater();
+
+    QJsonObject properties = feature.value("properties").toObject();
+    properties["corridorConflicts"] = json;
+    feature["properties"] = properties;
+
+    // An advisory like geofence violations, the path is still saved
+    if (!json.isEmpty()) {
+        qDebug() << "Corridor of" << droneName << "overlaps the corridors of:" << drones.join(", ");
+        emit corridorConflictsFound(droneName, json);
+    }
 }
@@ -0,0 +1,63 @@
+#include "../../include/api/LatencyHistogram.h"
+#include <QtMath>
+
+namespace {
+// First bucket covers 0-100 ms, each following bucket is 25% wider
+const double FIRST_BUCKET_MS = 100.0;
+const double BUCKET_GROWTH = 1.25;
+const int BUCKET_COUNT = 40;
+
+// Weight kept by older samples every time a new one is recorded
+const double DECAY = 0.97;
+}
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets(BUCKET_COUNT, 0.0)
+    , m_totalWeight(0.0)
+    , m_sampleCount(0)
+{
+}
+
+void LatencyHistogram::record(qint64 latencyMs)
+{
+    // Age the existing samples so the histogram tracks recent latency
+    for (double& bucket : m_buckets) {
+        bucket *= DECAY;
+    }
+    m_totalWeight *= DECAY;
+
+    m_buckets[bucketFor(latencyMs)] += 1.0;
+    m_totalWeight += 1.0;
+    m_sampleCount++;
+}
+
+qint64 LatencyHistogram::percentile(double quantile) const
+{
+    if (m_sampleCount == 0 || m_totalWeight <= 0.0) {
+        return -1;
+    }
+
+    double target = qBound(0.0, quantile, 1.0) * m_totalWeight;
+    double cumulative = 0.0;
+    for (int i = 0; i < m_buckets.size(); ++i) {
+        cumulative += m_buckets[i];
+        if (cumulative >= target) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(m_buckets.size() - 1);
+}
+
+int LatencyHistogram::bucketFor(qint64 latencyMs) const
+{
+    if (latencyMs <= FIRST_BUCKET_MS) {
+        return 0;
+    }
+    int bucket = qCeil(qLn(latencyMs / FIRST_BUCKET_MS) / qLn(BUCKET_GROWTH));
+    return qBound(0, bucket, BUCKET_COUNT - 1);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int bucket) const
+{
+    return qRound64(FIRST_BUCKET_MS * qPow(BUCKET_GROWTH, bucket));
+}
@@ -61,6 +61,8 @@ void MissionControl::setupUI()
     
     vehicleCombo = new QComboBox();
     vehicleCombo->addItems({"Atlas", "Bolt", "Barbarian"});
+    // Item data marks the entry that plans every vehicle above it
+    vehicleCombo->addItem("All Vehicles", true);
     vehicleCombo->setMinimumHeight(36);
     missionLayout->addWidget(vehicleCombo);
 
@@ -176,11 +178,25 @@ void MissionControl::handleAssignTask()
     QString vehicle = vehicleCombo->currentText();
     QString prompt = promptTextEdit->toPlainText().trimmed();
     
-    // Emit signal for mission assignment
-    emit missionAssigned(missionType, vehicle, prompt);
+    // The whole fleet is every vehicle of the combo but the fleet entry
+    QStringList fleet;
+    if (vehicleCombo->currentData().toBool()) {
+        for (int i = 0; i < vehicleCombo->count(); ++i) {
+            if (!vehicleCombo->itemData(i).toBool()) {
+                fleet << vehicleCombo->itemText(i);
+            }
+        }
+    }
     
-    // Send to ChatGPT API
-    ChatGPTClient::instance().sendPrompt(missionType, vehicle, prompt);
+    // Emit signal for mission assignment, naming the vehicles of a fleet
+    emit missionAssigned(missionType, fleet.isEmpty() ? vehicle : fleet.join(", "), prompt);
+    
+    // Send to ChatGPT API, the whole fleet is planned in a single request
+    if (!fleet.isEmpty()) {
+        ChatGPTClient::instance().sendFleetPrompt(missionType, fleet, prompt);
+    } else {
+        ChatGPTClient::instance().sendPrompt(missionType, vehicle, prompt);
+    }
     
     // Show loading indicator or message
     QMessageBox::information(nullptr, "Task Assigned", 
@@ -2,6 +2,11 @@
 #include "../../include/map/mapfunctions.h"
 #include "../../include/map/mapbox.h"
 #include "../../include/map/geometry.h"
+#include "../../include/map/filewatcher.h"
+#include "../../include/map/corridormonitor.h"
+#include "../../include/map/mbtilesschemehandler.h"
+#include "../../include/drone/FleetPathStore.h"
+#include "../../include/drone/UpdateBus.h"
 #include "../../include/simulation/SimulationView.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -14,6 +19,7 @@
 #include <QJsonDocument>
 #include <QCoreApplication>
 #include <QDir>
+#include <QStandardPaths>
 
 // Custom WebEnginePage for debugging
 DebugWebEnginePage::DebugWebEnginePage(QWebEngineProfile *profile, QObject *parent)
@@ -30,7 +36,12 @@ void DebugWebEnginePage::javaScriptConsoleMessage(JavaScriptConsoleMessageLevel
         case ErrorMessageLevel: levelStr = "ERROR"; break;
     }
     
-    qDebug() << "JS:" << levelStr << message << "at line" << lineNumber << "in" << sourceID;
+    // The page batches its log lines, one message may hold several
+    if (level == ErrorMessageLevel) {
+        qWarning().noquote() << "JS:" << levelStr << message << "at line" << lineNumber << "in" << sourceID;
+    } else {
+        qDebug().noquote() << "JS:" << levelStr << message << "at line" << lineNumber << "in" << sourceID;
+    }
 }
 
 MapViewer::MapViewer(QWidget* parent) : QWidget(parent)
@@ -39,7 +50,19 @@ MapViewer::MapViewer(QWidget* parent) : QWidget(parent)
     m_stackedWidget = new QStackedWidget(this);
     
     // Create a QWebEngineView with a custom page for debugging
-    QWebEngineProfile* profile = new QWebEngineProfile(this);
+    // A named profile keeps its HTTP and script caches on disk between runs,
+    // so tiles, styles and compiled scripts are not fetched again on start
+    QWebEngineProfile* profile = new QWebEngineProfile(QStringLiteral("map"), this);
+    QString cacheRoot = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/webengine";
+    profile->setCachePath(cacheRoot + "/cache");
+    profile->setPersistentStoragePath(cacheRoot + "/storage");
+    profile->setHttpCacheType(QWebEngineProfile::DiskHttpCache);
+    profile->setHttpCacheMaximumSize(256 * 1024 * 1024);
+    
+    // Serve the offline tile store when one has been seeded
+    MbtilesSchemeHandler* tileHandler = new MbtilesSchemeHandler(MbtilesSchemeHandler::defaultStorePath(), this);
+    profile->installUrlSchemeHandler(MbtilesSchemeHandler::SCHEME, tileHandler);
+    
     DebugWebEnginePage* page = new DebugWebEnginePage(profile, this);
     
     m_webView = new QWebEngineView(this);
@@ -58,10 +81,8 @@ MapViewer::MapViewer(QWidget* parent) : QWidget(parent)
     mainLayout->addWidget(m_stackedWidget);
     mainLayout->setContentsMargins(0, 0, 0, 0);
     
-    // Set up the file check timer
-    m_fileCheckTimer = new QTimer(this);
-    connect(m_fileCheckTimer, &QTimer::timeout, this, &MapViewer::checkForFileChanges);
-    m_fileCheckTimer->start(1000); // Check every second
+    // Recover paths left by a crashed session before the map subscribes
+    FleetPathStore::instance();
     
     // Create the MapFunctions instance and connect signals
     m_mapFunctions = new MapFunctions(m_webView, this);
@@ -70,20 +91,45 @@ MapViewer::MapViewer(QWidget* parent) : QWidget(parent)
     
     // Create the Mapbox instance and load the map
     m_mapbox = new Mapbox(m_webView, this);
+    m_mapbox->setOfflineTilesEnabled(tileHandler->isOpen());
     m_mapbox->loadMap();
+    connect(m_mapbox, &Mapbox::zoomBandChanged, m_mapFunctions, &MapFunctions::setZoomBand);
     
     // Create the Geometry instance and connect signals
     m_geometry = new Geometry(m_webView, this);
     connect(m_geometry, &Geometry::geometricShapeSaved, this, &MapViewer::geometricShapeSaved);
+    connect(m_geometry, &Geometry::importProgress, this, &MapViewer::importProgress);
+    connect(m_geometry, &Geometry::importFinished, this, &MapViewer::importFinished);
+    
+    // Every fleet update is checked against zones and planned corridors
+    m_corridorMonitor = new CorridorMonitor(this);
+    connect(m_corridorMonitor, &CorridorMonitor::conflictsChanged, this, &MapViewer::corridorConflictsChanged);
+    
+    // Shapes edited on disk are picked up through inotify
+    m_fileWatcher = new FileWatcher(this);
+    m_fileWatcher->watchFile(QDir::currentPath() + "/drone_geojson/geometric_shapes.geojson");
+    connect(m_fileWatcher, &FileWatcher::filesChanged, m_geometry, &Geometry::loadGeometricShapes);
     
     // Initial check for file changes
     QTimer::singleShot(500, this, &MapViewer::checkForFileChanges);
 }
 
 void MapViewer::setDronePositions(const QVector<QVector3D>& positions)
+{
+    // Publish so every view (map, simulation) receives the same snapshot
+    UpdateBus::instance().publishPositions(positions);
+}
+
+void MapViewer::setFleetStates(const QVector<DroneState>& drones)
+{
+    // Publish so every view receives the same snapshot
+    UpdateBus::instance().publishFleet(drones);
+}
+
+void MapViewer::setTrailLength(int maxPoints, int maxSeconds)
 {
     // Forward to MapFunctions
-    m_mapFunctions->setDronePositions(positions);
+    m_mapFunctions->setTrailLength(maxPoints, maxSeconds);
 }
 
 void MapViewer::updateDronePath(const QJsonObject& geojsonData)
@@ -98,6 +144,30 @@ void MapViewer::setActiveDrone(const QString& droneName)
     m_mapFunctions->setActiveDrone(droneName);
 }
 
+void MapViewer::startDroneAnimation(const QString& droneName, double speedMetersPerSecond)
+{
+    // Forward to MapFunctions
+    m_mapFunctions->startDroneAnimation(droneName, speedMetersPerSecond);
+}
+
+void MapViewer::startFleetAnimation(const QStringList& droneNames, double speedMetersPerSecond)
+{
+    // Forward to MapFunctions
+    m_mapFunctions->startFleetAnimation(droneNames, speedMetersPerSecond);
+}
+
+void MapViewer::stopDroneAnimation(const QString& droneName)
+{
+    // Forward to MapFunctions
+    m_mapFunctions->stopDroneAnimation(droneName);
+}
+
+void MapViewer::stopAllDroneAnimations()
+{
+    // Forward to MapFunctions
+    m_mapFunctions->stopAllDroneAnimations();
+}
+
 void MapViewer::saveGeometryData(const QString& geometryData)
 {
     // Forward to Geometry instead of MapFunctions
@@ -134,6 +204,12 @@ void MapViewer::deleteGeometricShape(const QString& shapeName)
     m_geometry->deleteGeometricShape(shapeName);
 }
 
+bool MapViewer::importGeometricShapes(const QString& filePath, const QString& shapeName)
+{
+    // Forward to Geometry instead of MapFunctions
+    return m_geometry->importGeometricShapes(filePath, shapeName);
+}
+
 void MapViewer::clearDronePathsOnExit()
 {
     // Forward to MapFunctions
@@ -56,6 +56,26 @@ TopBar::TopBar(QWidget* parent) : QToolBar(parent)
     QLabel* statusLabel = new QLabel("● Online");
     statusLabel->setStyleSheet("color: #4CAF50; font-size: 12px;");
     
+    // Import geofences from a GeoJSON file
+    importButton = new QPushButton("Import Zones");
+    importButton->setToolTip("Load geometric shapes from a GeoJSON file");
+    importButton->setStyleSheet(R"(
+        QPushButton {
+            background-color: #252525;
+            color: #e0e0e0;
+            border: 1px solid #00a6ff;
+            border-radius: 4px;
+            padding: 5px 10px;
+            font-size: 12px;
+        }
+        QPushButton:hover {
+            background-color: #00a6ff;
+            color: #121212;
+        }
+    )");
+    connect(importButton, &QPushButton::clicked, this, &TopBar::importShapesRequested);
+    
+    rightLayout->addWidget(importButton);
     rightLayout->addWidget(dateTimeLabel);
     rightLayout->addWidget(statusLabel);
     
@@ -8,11 +8,15 @@
 #include <QMap>
 #include <QCoreApplication>
 #include <QDateTime>
+#include "../../include/drone/UpdateBus.h"
 
 // Static map to store drone paths and metadata
 static QMap<QString, QJsonArray> dronePathsMap;
 static QMap<QString, QString> droneOperationTypes;
 
+// Files are only a persistence sink, views receive paths through the UpdateBus
+static bool persistenceEnabled = true;
+
 // Base location coordinates
 const double BASE_LONGITUDE = 10.3624;
 const double BASE_LATITUDE = 77.9695;
@@ -59,8 +63,19 @@ QJsonObject createPathFeature(const QJsonArray& coordinates, const QString& colo
     return feature;
 }
 
-// Helper function to save flight path GeoJSON
+// Helper function to publish and save flight path GeoJSON
 bool saveFlightPath(const QString& droneName) {
+    // Publish the trail in-process first, apart from the planned paths
+    QJsonObject pathFeature = createPathFeature(dronePathsMap[droneName]);
+    QJsonObject pathProperties = pathFeature["properties"].toObject();
+    pathProperties["name"] = droneName;
+    pathFeature["properties"] = pathProperties;
+    UpdateBus::instance().publishCommandTrail(droneName, pathFeature);
+    
+    if (!persistenceEnabled) {
+        return true;
+    }
+    
     // Get the application directory path
     QString appPath = QCoreApplication::applicationDirPath();
     QDir dir(appPath);
@@ -205,4 +220,8 @@ bool DroneFunctions::arm(const QString& droneName) {
 bool DroneFunctions::disarm(const QString& droneName) {
     droneOperationTypes[droneName] = "disarm";
     return saveFlightPath(droneName);
-} 
\ No newline at end of file
+}
+
+void DroneFunctions::setPersistenceEnabled(bool enabled) {
+    persistenceEnabled = enabled;
+}
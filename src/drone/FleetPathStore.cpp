@@ -0,0 +1,301 @@
+#include "../../include/drone/FleetPathStore.h"
+#include "../../include/drone/UpdateBus.h"
+#include "../../include/map/binarygeometry.h"
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QUrl>
+#include <QDebug>
+#include <limits>
+
+namespace {
+// Compact once the log holds this many records per drone
+const int LOG_RECORDS_PER_DRONE = 4;
+const int MIN_LOG_RECORDS = 16;
+
+// Snapshot features carry the name their path is stored under as a foreign
+// member, the same key the log records use
+const char* SNAPSHOT_KEY = "drone";
+}
+
+FleetPathStore& FleetPathStore::instance()
+{
+    static FleetPathStore instance;
+    return instance;
+}
+
+FleetPathStore::FleetPathStore(QObject* parent)
+    : QObject(parent)
+    , m_directory(QDir::currentPath() + "/drone_geojson")
+    , m_revision(0)
+    , m_logRecords(0)
+    , m_persistenceEnabled(true)
+    , m_cachedRevision(std::numeric_limits<quint64>::max())
+{
+    // Ensure directory exists
+    QDir dir(m_directory);
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    load();
+}
+
+FleetPathStore::~FleetPathStore()
+{
+}
+
+void FleetPathStore::replacePath(const QString& droneName, const QJsonObject& feature)
+{
+    m_paths.insert(droneName, feature);
+    m_displayOnly.remove(droneName);
+    m_revision++;
+
+    qDebug() << "Stored path for drone:" << droneName;
+    UpdateBus::instance().publishPath(droneName, feature);
+
+    // Only this drone's data touches the disk
+    if (m_persistenceEnabled) {
+        QJsonObject record;
+        record["op"] = "put";
+        record["drone"] = droneName;
+        record["feature"] = feature;
+        appendLogRecord(record);
+        writeSegment(droneName, feature);
+        compactIfNeeded();
+    }
+}
+
+void FleetPathStore::showPath(const QString& droneName, const QJsonObject& feature)
+{
+    m_paths.insert(droneName, feature);
+    m_displayOnly.insert(droneName);
+    m_revision++;
+
+    UpdateBus::instance().publishPath(droneName, feature);
+}
+
+void FleetPathStore::removePath(const QString& droneName)
+{
+    if (!m_paths.remove(droneName)) {
+        return;
+    }
+    m_revision++;
+    const bool displayOnly = m_displayOnly.remove(droneName);
+
+    UpdateBus::instance().publishPathRemoved(droneName);
+
+    if (m_persistenceEnabled && !displayOnly) {
+        QJsonObject record;
+        record["op"] = "remove";
+        record["drone"] = droneName;
+        appendLogRecord(record);
+        QFile::remove(segmentPath(droneName));
+        compactIfNeeded();
+    }
+}
+
+QJsonObject FleetPathStore::featureCollection() const
+{
+    if (m_cachedRevision != m_revision) {
+        QJsonArray features;
+        for (const QJsonObject& feature : m_paths) {
+            features.append(feature);
+        }
+
+        m_cachedCollection = QJsonObject();
+        m_cachedCollection["type"] = "FeatureCollection";
+        m_cachedCollection["features"] = features;
+        m_cachedRevision = m_revision;
+    }
+    return m_cachedCollection;
+}
+
+void FleetPathStore::clear()
+{
+    for (const QString& droneName : m_paths.keys()) {
+        QFile::remove(segmentPath(droneName));
+    }
+    QFile::remove(snapshotPath());
+    QFile::remove(legacySnapshotPath());
+    QFile::remove(logPath());
+
+    QStringList droneNames = m_paths.keys();
+    m_paths.clear();
+    m_displayOnly.clear();
+    m_logRecords = 0;
+    m_revision++;
+
+    for (const QString& droneName : droneNames) {
+        UpdateBus::instance().publishPathRemoved(droneName);
+    }
+}
+
+bool FleetPathStore::compact()
+{
+    QVector<QJsonObject> features;
+    features.reserve(m_paths.size());
+    for (auto it = m_paths.constBegin(); it != m_paths.constEnd(); ++it) {
+        if (m_displayOnly.contains(it.key())) {
+            continue;
+        }
+        QJsonObject feature = it.value();
+        feature[SNAPSHOT_KEY] = it.key();
+        features.append(feature);
+    }
+
+    if (!BinaryGeometryFile::write(snapshotPath(), features)) {
+        return false;
+    }
+    QFile::remove(legacySnapshotPath());
+
+    // The snapshot now holds everything the log described
+    QFile log(logPath());
+    if (log.exists() && !log.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to truncate drone paths log:" << log.errorString();
+        return false;
+    }
+    log.close();
+    m_logRecords = 0;
+
+    qDebug() << "Compacted drone paths snapshot with" << features.size() << "paths";
+    return true;
+}
+
+void FleetPathStore::load()
+{
+    // Files are only left by a session that did not exit cleanly. Start from
+    // its last snapshot, or the GeoJSON one written before the binary format
+    QVector<QJsonObject> features;
+    BinaryGeometryFile snapshot;
+    if (snapshot.open(snapshotPath())) {
+        for (int i = 0; i < snapshot.count(); ++i) {
+            features.append(snapshot.feature(i));
+        }
+    } else {
+        QFile legacy(legacySnapshotPath());
+        if (legacy.open(QIODevice::ReadOnly)) {
+            const QJsonArray values = QJsonDocument::fromJson(legacy.readAll()).object().value("features").toArray();
+            for (const QJsonValue& value : values) {
+                features.append(value.toObject());
+            }
+        }
+    }
+
+    for (QJsonObject feature : features) {
+        // The GeoJSON snapshot predates the stored key and was keyed by name
+        QString droneName = feature.contains(SNAPSHOT_KEY)
+            ? feature.take(SNAPSHOT_KEY).toString()
+            : feature.value("properties").toObject().value("name").toString();
+        if (!droneName.isEmpty()) {
+            m_paths.insert(droneName, feature);
+        }
+    }
+
+    // Replay changes recorded after the snapshot
+    QFile log(logPath());
+    if (log.open(QIODevice::ReadOnly)) {
+        while (!log.atEnd()) {
+            QByteArray line = log.readLine().trimmed();
+            if (line.isEmpty()) {
+                continue;
+            }
+
+            QJsonObject record = QJsonDocument::fromJson(line).object();
+            QString droneName = record.value("drone").toString();
+            if (record.value("op").toString() == "put") {
+                m_paths.insert(droneName, record.value("feature").toObject());
+            } else if (record.value("op").toString() == "remove") {
+                m_paths.remove(droneName);
+            }
+            m_logRecords++;
+        }
+        log.close();
+    }
+
+    if (!m_paths.isEmpty()) {
+        m_revision++;
+
+        // Make recovered paths available to views created later
+        for (auto it = m_paths.constBegin(); it != m_paths.constEnd(); ++it) {
+            UpdateBus::instance().publishPath(it.key(), it.value());
+        }
+        qDebug() << "Loaded" << m_paths.size() << "drone paths," << m_logRecords << "log records";
+    }
+}
+
+void FleetPathStore::appendLogRecord(const QJsonObject& record)
+{
+    QFile log(logPath());
+    if (!log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to append to drone paths log:" << log.errorString();
+        return;
+    }
+
+    log.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+    log.write("\n");
+    log.close();
+    m_logRecords++;
+}
+
+void FleetPathStore::writeSegment(const QString& droneName, const QJsonObject& feature)
+{
+    // Per-drone file with just this feature
+    QJsonObject singleDroneGeoJson;
+    singleDroneGeoJson["type"] = "FeatureCollection";
+    singleDroneGeoJson["features"] = QJsonArray{feature};
+
+    QSaveFile segment(segmentPath(droneName));
+    if (segment.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        segment.write(QJsonDocument(singleDroneGeoJson).toJson(QJsonDocument::Indented));
+        segment.commit();
+    } else {
+        qWarning() << "Failed to save path segment for drone:" << droneName << "-" << segment.errorString();
+    }
+}
+
+void FleetPathStore::compactIfNeeded()
+{
+    if (m_logRecords >= qMax(MIN_LOG_RECORDS, LOG_RECORDS_PER_DRONE * m_paths.size())) {
+        compact();
+    }
+}
+
+bool FleetPathStore::exportGeoJson(const QString& path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Failed to open drone paths export:" << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(featureCollection()).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        qWarning() << "Failed to write drone paths export:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString FleetPathStore::snapshotPath() const
+{
+    return m_directory + "/all_drone_paths.dgb";
+}
+
+QString FleetPathStore::legacySnapshotPath() const
+{
+    return m_directory + "/all_drone_paths.geojson";
+}
+
+QString FleetPathStore::logPath() const
+{
+    return m_directory + "/all_drone_paths.log";
+}
+
+QString FleetPathStore::segmentPath(const QString& droneName) const
+{
+    // Names come from the LLM and the user, keep separators and reserved
+    // characters out of the file name
+    const QString fileName = QString::fromLatin1(QUrl::toPercentEncoding(droneName));
+    return QString("%1/%2_path.geojson").arg(m_directory, fileName);
+}
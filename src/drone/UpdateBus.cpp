@@ -0,0 +1,96 @@
+#include "../../include/drone/UpdateBus.h"
+#include <QDateTime>
+
+UpdateBus& UpdateBus::instance()
+{
+    static UpdateBus instance;
+    return instance;
+}
+
+UpdateBus::UpdateBus(QObject* parent)
+    : QObject(parent)
+    , m_revision(0)
+{
+    // Allow snapshots to travel through queued connections
+    qRegisterMetaType<PathSnapshotPtr>("PathSnapshotPtr");
+    qRegisterMetaType<ShapesSnapshotPtr>("ShapesSnapshotPtr");
+    qRegisterMetaType<ShapeChangesPtr>("ShapeChangesPtr");
+    qRegisterMetaType<PositionsSnapshotPtr>("PositionsSnapshotPtr");
+    qRegisterMetaType<FleetSnapshotPtr>("FleetSnapshotPtr");
+}
+
+UpdateBus::~UpdateBus()
+{
+}
+
+void UpdateBus::publishPath(const QString& droneName, const QJsonObject& feature)
+{
+    QSharedPointer<PathSnapshot> snapshot(new PathSnapshot);
+    snapshot->droneName = droneName;
+    snapshot->feature = feature;
+    snapshot->revision = ++m_revision;
+
+    m_paths.insert(droneName, snapshot);
+    emit pathPublished(snapshot);
+}
+
+void UpdateBus::publishPathRemoved(const QString& droneName)
+{
+    QSharedPointer<PathSnapshot> snapshot(new PathSnapshot);
+    snapshot->droneName = droneName;
+    snapshot->revision = ++m_revision;
+
+    m_paths.remove(droneName);
+    emit pathPublished(snapshot);
+}
+
+void UpdateBus::publishCommandTrail(const QString& droneName, const QJsonObject& feature)
+{
+    QSharedPointer<PathSnapshot> snapshot(new PathSnapshot);
+    snapshot->droneName = droneName;
+    snapshot->feature = feature;
+    snapshot->revision = ++m_revision;
+
+    m_commandTrails.insert(droneName, snapshot);
+    emit commandTrailPublished(snapshot);
+}
+
+void UpdateBus::publishShapes(const QJsonObject& collection)
+{
+    QSharedPointer<ShapesSnapshot> snapshot(new ShapesSnapshot);
+    snapshot->collection = collection;
+    snapshot->revision = ++m_revision;
+
+    m_shapes = snapshot;
+    emit shapesPublished(snapshot);
+}
+
+void UpdateBus::publishShapeChanges(const QHash<QString, QJsonObject>& upserted, const QStringList& removed)
+{
+    QSharedPointer<ShapeChanges> changes(new ShapeChanges);
+    changes->upserted = upserted;
+    changes->removed = removed;
+    changes->revision = ++m_revision;
+
+    emit shapeChangesPublished(changes);
+}
+
+void UpdateBus::publishPositions(const QVector<QVector3D>& positions)
+{
+    QSharedPointer<PositionsSnapshot> snapshot(new PositionsSnapshot);
+    snapshot->positions = positions;
+    snapshot->timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    m_positions = snapshot;
+    emit positionsPublished(snapshot);
+}
+
+void UpdateBus::publishFleet(const QVector<DroneState>& drones)
+{
+    QSharedPointer<FleetSnapshot> snapshot(new FleetSnapshot);
+    snapshot->drones = drones;
+    snapshot->timestamp = QDateTime::currentMSecsSinceEpoch();
+
+    m_fleet = snapshot;
+    emit fleetPublished(snapshot);
+}
@@ -1,4 +1,5 @@
 #include "../include/MainWindow.h"
+#include "../include/map/mbtilesschemehandler.h"
 #include <QApplication>
 #include <QWebEngineSettings>
 #include <QDir>
@@ -76,6 +77,9 @@ int main(int argc, char *argv[]) {
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QCoreApplication::setAttribute(Qt::AA_UseDesktopOpenGL);
     
+    // Custom schemes must be known before the web engine starts
+    MbtilesSchemeHandler::registerScheme();
+    
     qInstallMessageHandler(messageHandler);
     QApplication app(argc, argv);
     
@@ -0,0 +1,451 @@
+#include "../../include/map/binarygeometry.h"
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QtEndian>
+#include <QtMath>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+const char MAGIC[4] = {'D', 'G', 'B', '1'};
+const quint32 FORMAT_VERSION = 1;
+const qint64 HEADER_SIZE = 48;
+const qint64 OFFSET_ENTRY_SIZE = 48;
+const double COORDINATE_SCALE = 1e7;
+const double ALTITUDE_SCALE = 100.0;
+
+const quint8 NO_GEOMETRY = 0;
+const quint8 RAW_GEOMETRY = 255;
+
+struct GeometryKind {
+    const char* name;
+    quint8 code;
+    int depth;  // array levels above the positions
+};
+
+const GeometryKind GEOMETRY_KINDS[] = {
+    {"Point", 1, 0},
+    {"LineString", 2, 1},
+    {"Polygon", 3, 2},
+    {"MultiPoint", 4, 1},
+    {"MultiLineString", 5, 2},
+    {"MultiPolygon", 6, 3},
+};
+
+const GeometryKind* kindByName(const QString& name)
+{
+    for (const GeometryKind& kind : GEOMETRY_KINDS) {
+        if (name == QLatin1String(kind.name)) {
+            return &kind;
+        }
+    }
+    return nullptr;
+}
+
+const GeometryKind* kindByCode(quint8 code)
+{
+    for (const GeometryKind& kind : GEOMETRY_KINDS) {
+        if (kind.code == code) {
+            return &kind;
+        }
+    }
+    return nullptr;
+}
+
+void appendUInt32(QByteArray& out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 4);
+}
+
+void appendUInt64(QByteArray& out, quint64 value)
+{
+    char bytes[8];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, 8);
+}
+
+void appendDouble(QByteArray& out, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendUInt64(out, bits);
+}
+
+void appendBox(QByteArray& out, const BoundingBox& box)
+{
+    // Null boxes are stored as NaN
+    const double nan = qQNaN();
+    appendDouble(out, box.isNull() ? nan : box.minX);
+    appendDouble(out, box.isNull() ? nan : box.minY);
+    appendDouble(out, box.isNull() ? nan : box.maxX);
+    appendDouble(out, box.isNull() ? nan : box.maxY);
+}
+
+void appendVarint(QByteArray& out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+quint64 zigzag(qint64 value)
+{
+    return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+qint64 unzigzag(quint64 value)
+{
+    return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+// Bounds checked reads from the mapped file
+struct Cursor {
+    const uchar* p;
+    const uchar* end;
+    bool ok;
+
+    bool has(qint64 bytes) const { return ok && end - p >= bytes; }
+
+    quint8 readUInt8()
+    {
+        if (!has(1)) {
+            ok = false;
+            return 0;
+        }
+        return *p++;
+    }
+
+    quint32 readUInt32()
+    {
+        if (!has(4)) {
+            ok = false;
+            return 0;
+        }
+        quint32 value = qFromLittleEndian<quint32>(p);
+        p += 4;
+        return value;
+    }
+
+    quint64 readVarint()
+    {
+        quint64 value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (!has(1)) {
+                break;
+            }
+            const uchar byte = *p++;
+            value |= quint64(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    QByteArray readBytes(quint32 size)
+    {
+        if (!has(size)) {
+            ok = false;
+            return QByteArray();
+        }
+        QByteArray bytes(reinterpret_cast<const char*>(p), int(size));
+        p += size;
+        return bytes;
+    }
+};
+
+double readDouble(const uchar* data)
+{
+    quint64 bits = qFromLittleEndian<quint64>(data);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+BoundingBox readBox(const uchar* data)
+{
+    BoundingBox box;
+    const double minX = readDouble(data);
+    if (qIsNaN(minX)) {
+        return box;
+    }
+    box.minX = minX;
+    box.minY = readDouble(data + 8);
+    box.maxX = readDouble(data + 16);
+    box.maxY = readDouble(data + 24);
+    return box;
+}
+
+// Child counts and position deltas in pre-order; fails on mixed dimensions
+bool encodeCoordinates(const QJsonArray& coordinates, int depth, int& stride, qint64 previous[3], QByteArray& out)
+{
+    if (depth == 0) {
+        if (coordinates.size() < 2 || coordinates.size() > 3 || (stride > 0 && coordinates.size() != stride)) {
+            return false;
+        }
+        stride = coordinates.size();
+        for (int i = 0; i < stride; ++i) {
+            if (!coordinates[i].isDouble()) {
+                return false;
+            }
+            const double scale = i < 2 ? COORDINATE_SCALE : ALTITUDE_SCALE;
+            const qint64 value = qRound64(coordinates[i].toDouble() * scale);
+            appendVarint(out, zigzag(value - previous[i]));
+            previous[i] = value;
+        }
+        return true;
+    }
+
+    appendVarint(out, quint64(coordinates.size()));
+    for (const QJsonValue& child : coordinates) {
+        if (!child.isArray() || !encodeCoordinates(child.toArray(), depth - 1, stride, previous, out)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QJsonArray decodeCoordinates(Cursor& cursor, int depth, int stride, qint64 previous[3])
+{
+    QJsonArray coordinates;
+    if (depth == 0) {
+        for (int i = 0; i < stride && cursor.ok; ++i) {
+            const double scale = i < 2 ? COORDINATE_SCALE : ALTITUDE_SCALE;
+            previous[i] += unzigzag(cursor.readVarint());
+            coordinates.append(previous[i] / scale);
+        }
+        return coordinates;
+    }
+
+    // Every child takes at least one byte, larger counts are damage
+    const quint64 count = cursor.readVarint();
+    if (!cursor.has(qint64(count))) {
+        cursor.ok = false;
+        return coordinates;
+    }
+    for (quint64 i = 0; i < count && cursor.ok; ++i) {
+        coordinates.append(decodeCoordinates(cursor, depth - 1, stride, previous));
+    }
+    return coordinates;
+}
+
+QByteArray encodeFeature(const QJsonObject& feature)
+{
+    QJsonObject head = feature;
+    head.remove("geometry");
+    const QByteArray headJson = QJsonDocument(head).toJson(QJsonDocument::Compact);
+
+    QByteArray record;
+    appendUInt32(record, quint32(headJson.size()));
+    record.append(headJson);
+
+    const QJsonValue geometryValue = feature.value("geometry");
+    if (!geometryValue.isObject()) {
+        record.append(char(NO_GEOMETRY));
+        record.append(3, char(0));
+        return record;
+    }
+
+    const QJsonObject geometry = geometryValue.toObject();
+    const GeometryKind* kind = kindByName(geometry.value("type").toString());
+    if (kind) {
+        QByteArray coordinates;
+        int stride = 0;
+        qint64 previous[3] = {0, 0, 0};
+        const QJsonValue value = geometry.value("coordinates");
+        if (value.isArray() && encodeCoordinates(value.toArray(), kind->depth, stride, previous, coordinates)) {
+            record.append(char(kind->code));
+            record.append(char(stride > 0 ? stride : 2));
+            record.append(2, char(0));
+            record.append(coordinates);
+            return record;
+        }
+    }
+
+    const QByteArray geometryJson = QJsonDocument(geometry).toJson(QJsonDocument::Compact);
+    record.append(char(RAW_GEOMETRY));
+    record.append(3, char(0));
+    appendUInt32(record, quint32(geometryJson.size()));
+    record.append(geometryJson);
+    return record;
+}
+}
+
+BinaryGeometryFile::BinaryGeometryFile()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_count(0)
+{
+}
+
+BinaryGeometryFile::~BinaryGeometryFile()
+{
+    close();
+}
+
+bool BinaryGeometryFile::write(const QString& path, const QVector<QJsonObject>& features,
+                               const QVector<BoundingBox>& boxes)
+{
+    const qint64 dataStart = HEADER_SIZE + OFFSET_ENTRY_SIZE * features.size();
+
+    BoundingBox bounds;
+    QByteArray table;
+    QByteArray body;
+    table.reserve(int(OFFSET_ENTRY_SIZE * features.size()));
+    for (int i = 0; i < features.size(); ++i) {
+        const BoundingBox box = i < boxes.size() ? boxes[i]
+                                                 : BoundingBox::ofGeometry(features[i].value("geometry").toObject());
+        if (!box.isNull()) {
+            bounds.expand(box);
+        }
+
+        const QByteArray record = encodeFeature(features[i]);
+        appendUInt64(table, quint64(dataStart + body.size()));
+        appendUInt32(table, quint32(record.size()));
+        appendUInt32(table, 0);
+        appendBox(table, box);
+        body.append(record);
+    }
+
+    QByteArray header(MAGIC, 4);
+    appendUInt32(header, FORMAT_VERSION);
+    appendUInt32(header, quint32(features.size()));
+    appendUInt32(header, 0);
+    appendBox(header, bounds);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open binary geometry file:" << file.errorString();
+        return false;
+    }
+    file.write(header);
+    file.write(table);
+    file.write(body);
+    if (!file.commit()) {
+        qWarning() << "Failed to write binary geometry file:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool BinaryGeometryFile::open(const QString& path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    const uchar* data = m_size >= HEADER_SIZE ? m_file.map(0, m_size) : nullptr;
+    if (!data) {
+        m_error = m_size < HEADER_SIZE ? QString("File too small") : m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>(data + 4);
+    const quint32 count = qFromLittleEndian<quint32>(data + 8);
+    if (std::memcmp(data, MAGIC, 4) != 0 || version != FORMAT_VERSION) {
+        m_error = "Not a binary geometry file";
+    } else if (HEADER_SIZE + OFFSET_ENTRY_SIZE * qint64(count) > m_size) {
+        m_error = "Truncated offset table";
+    }
+    if (!m_error.isEmpty()) {
+        m_file.unmap(const_cast<uchar*>(data));
+        m_file.close();
+        return false;
+    }
+
+    m_data = data;
+    m_count = int(count);
+    return true;
+}
+
+void BinaryGeometryFile::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_size = 0;
+    m_count = 0;
+    m_error.clear();
+}
+
+BoundingBox BinaryGeometryFile::bounds() const
+{
+    return m_data ? readBox(m_data + 16) : BoundingBox();
+}
+
+BoundingBox BinaryGeometryFile::featureBounds(int index) const
+{
+    if (!m_data || index < 0 || index >= m_count) {
+        return BoundingBox();
+    }
+    return readBox(m_data + HEADER_SIZE + OFFSET_ENTRY_SIZE * index + 16);
+}
+
+QJsonObject BinaryGeometryFile::feature(int index) const
+{
+    if (!m_data || index < 0 || index >= m_count) {
+        return QJsonObject();
+    }
+
+    const uchar* entry = m_data + HEADER_SIZE + OFFSET_ENTRY_SIZE * index;
+    const quint64 offset = qFromLittleEndian<quint64>(entry);
+    const quint32 size = qFromLittleEndian<quint32>(entry + 8);
+    if (offset > quint64(m_size) || size > quint64(m_size) - offset) {
+        return QJsonObject();
+    }
+
+    Cursor cursor{m_data + offset, m_data + offset + size, true};
+    QJsonObject feature = QJsonDocument::fromJson(cursor.readBytes(cursor.readUInt32())).object();
+
+    const quint8 type = cursor.readUInt8();
+    const quint8 stride = cursor.readUInt8();
+    cursor.readUInt8();
+    cursor.readUInt8();
+    if (!cursor.ok) {
+        return QJsonObject();
+    }
+
+    if (type == RAW_GEOMETRY) {
+        feature["geometry"] = QJsonDocument::fromJson(cursor.readBytes(cursor.readUInt32())).object();
+    } else if (const GeometryKind* kind = kindByCode(type)) {
+        if (stride < 2 || stride > 3) {
+            return QJsonObject();
+        }
+        qint64 previous[3] = {0, 0, 0};
+        QJsonObject geometry;
+        geometry["type"] = QLatin1String(kind->name);
+        geometry["coordinates"] = decodeCoordinates(cursor, kind->depth, stride, previous);
+        feature["geometry"] = geometry;
+    } else {
+        feature["geometry"] = QJsonValue();
+    }
+    return cursor.ok ? feature : QJsonObject();
+}
+
+QJsonObject BinaryGeometryFile::toFeatureCollection() const
+{
+    QJsonArray features;
+    for (int i = 0; i < m_count; ++i) {
+        features.append(feature(i));
+    }
+
+    QJsonObject collection;
+    collection["type"] = "FeatureCollection";
+    collection["features"] = features;
+    return collection;
+}
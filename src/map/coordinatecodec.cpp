@@ -0,0 +1,172 @@
+#include "../../include/map/coordinatecodec.h"
+#include <QByteArray>
+#include <QtEndian>
+#include <QJsonDocument>
+#include <cstring>
+
+QString CoordinateCodec::packFloat32(const QVector<float>& values)
+{
+    QByteArray buffer(values.size() * int(sizeof(quint32)), Qt::Uninitialized);
+    char* out = buffer.data();
+    for (float value : values) {
+        quint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        qToLittleEndian(bits, out);
+        out += sizeof(bits);
+    }
+    return QString::fromLatin1(buffer.toBase64());
+}
+
+QString CoordinateCodec::packFloat64(const QVector<double>& values)
+{
+    QByteArray buffer(values.size() * int(sizeof(quint64)), Qt::Uninitialized);
+    char* out = buffer.data();
+    for (double value : values) {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        qToLittleEndian(bits, out);
+        out += sizeof(bits);
+    }
+    return QString::fromLatin1(buffer.toBase64());
+}
+
+QString CoordinateCodec::packPositions(const QVector<QVector3D>& positions)
+{
+    QVector<float> values;
+    values.reserve(positions.size() * 3);
+    for (const QVector3D& pos : positions) {
+        values << pos.x() << pos.y() << pos.z();
+    }
+    return packFloat32(values);
+}
+
+QString CoordinateCodec::packPath(const QJsonArray& coordinates, int* stride)
+{
+    QVector<double> values;
+    QVector<QJsonArray> counts;
+    int pathStride = 0;
+    if (!flatten(coordinates, 1, 0, values, counts, pathStride)) {
+        values.clear();
+        pathStride = 2;
+    }
+
+    if (stride) {
+        *stride = pathStride > 0 ? pathStride : 2;
+    }
+    return packFloat64(values);
+}
+
+QJsonObject CoordinateCodec::packGeometry(const QJsonObject& geometry)
+{
+    const QString type = geometry.value("type").toString();
+    const int depth = nestingDepth(type);
+    if (depth < 0) {
+        return geometry;
+    }
+
+    QVector<double> values;
+    QVector<QJsonArray> counts(qMax(0, depth - 1));
+    int stride = 0;
+    const QJsonValue coordinates = geometry.value("coordinates");
+    if (!coordinates.isArray() || !flatten(coordinates.toArray(), depth, 0, values, counts, stride)) {
+        return geometry;
+    }
+
+    QJsonArray countsArray;
+    for (const QJsonArray& levelCounts : counts) {
+        countsArray.append(levelCounts);
+    }
+
+    QJsonObject packed;
+    packed["type"] = type;
+    packed["packed"] = packFloat64(values);
+    packed["stride"] = stride > 0 ? stride : 2;
+    packed["counts"] = countsArray;
+    return packed;
+}
+
+QJsonObject CoordinateCodec::packFeature(const QJsonObject& feature)
+{
+    if (!feature.value("geometry").isObject()) {
+        return feature;
+    }
+
+    QJsonObject packed = feature;
+    packed["geometry"] = packGeometry(feature.value("geometry").toObject());
+    return packed;
+}
+
+QJsonObject CoordinateCodec::packFeatureCollection(const QJsonObject& collection)
+{
+    QJsonArray features = collection.value("features").toArray();
+    for (int i = 0; i < features.size(); ++i) {
+        features[i] = packFeature(features[i].toObject());
+    }
+
+    QJsonObject packed = collection;
+    packed["features"] = features;
+    return packed;
+}
+
+QString CoordinateCodec::scriptStringLiteral(const QJsonObject& json)
+{
+    return scriptStringLiteral(QString::fromUtf8(QJsonDocument(json).toJson(QJsonDocument::Compact)));
+}
+
+QString CoordinateCodec::scriptStringLiteral(const QString& text)
+{
+    // A JSON string is a valid JavaScript string literal
+    QByteArray quoted = QJsonDocument(QJsonArray{text}).toJson(QJsonDocument::Compact);
+    return QString::fromUtf8(quoted.mid(1, quoted.size() - 2));
+}
+
+int CoordinateCodec::nestingDepth(const QString& geometryType)
+{
+    if (geometryType == "Point") {
+        return 0;
+    }
+    if (geometryType == "LineString" || geometryType == "MultiPoint") {
+        return 1;
+    }
+    if (geometryType == "Polygon" || geometryType == "MultiLineString") {
+        return 2;
+    }
+    if (geometryType == "MultiPolygon") {
+        return 3;
+    }
+    return -1;
+}
+
+bool CoordinateCodec::flatten(const QJsonArray& coordinates, int depth, int level,
+                              QVector<double>& values, QVector<QJsonArray>& counts, int& stride)
+{
+    // Reached a single position
+    if (level == depth) {
+        if (coordinates.size() < 2 || (stride > 0 && coordinates.size() != stride)) {
+            return false;
+        }
+        stride = coordinates.size();
+        for (const QJsonValue& value : coordinates) {
+            if (!value.isDouble()) {
+                return false;
+            }
+            values.append(value.toDouble());
+        }
+        return true;
+    }
+
+    // The size of the outermost array is implied by the next level
+    if (level > 0) {
+        if (counts.size() < level) {
+            counts.resize(level);
+        }
+        counts[level - 1].append(coordinates.size());
+    }
+
+    for (const QJsonValue& child : coordinates) {
+        if (!child.isArray() || !flatten(child.toArray(), depth, level + 1, values, counts, stride)) {
+            return false;
+        }
+    }
+    return true;
+}
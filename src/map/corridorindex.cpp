@@ -0,0 +1,406 @@
+#include "../../include/map/corridorindex.h"
+#include "../../include/map/polygonclipper.h"
+#include <QtMath>
+#include <limits>
+
+namespace {
+const double UNBOUNDED = std::numeric_limits<double>::max();
+
+// Segments from the base, left out of corridor comparisons
+const int LAUNCH_SEGMENTS = 1;
+
+const char* conflictTypeName(CorridorConflict::Type type)
+{
+    return type == CorridorConflict::Corridor ? "corridor" : "zone";
+}
+
+bool bandsOverlap(double low1, double high1, double low2, double high2)
+{
+    return low1 <= high2 && low2 <= high1;
+}
+
+// Degree box around two [lng, lat] points, grown by a margin in meters
+// where a degree of longitude is shortest
+BoundingBox boxAround(const QPointF& a, const QPointF& b, double marginMeters)
+{
+    BoundingBox box;
+    box.expand(a.x(), a.y());
+    box.expand(b.x(), b.y());
+
+    const LocalProjection local(box.centerX(), qMin(89.0, qMax(qAbs(box.minY), qAbs(box.maxY))));
+    box.minX -= local.lngDegrees(marginMeters);
+    box.maxX += local.lngDegrees(marginMeters);
+    box.minY -= local.latDegrees(marginMeters);
+    box.maxY += local.latDegrees(marginMeters);
+    return box;
+}
+
+// Projection around the middle of a segment, for distances near it
+LocalProjection projectionAround(const QPointF& a, const QPointF& b)
+{
+    return LocalProjection((a.x() + b.x()) / 2.0, (a.y() + b.y()) / 2.0);
+}
+
+// Keeps the closest conflict per other zone or drone
+void keepClosest(QMap<QString, CorridorConflict>& closest, const CorridorConflict& conflict)
+{
+    auto it = closest.find(conflict.otherId);
+    if (it == closest.end() || conflict.gapMeters < it->gapMeters) {
+        closest.insert(conflict.otherId, conflict);
+    }
+}
+}
+
+QJsonObject CorridorConflict::toJson() const
+{
+    QJsonObject json;
+    json["segment"] = segment;
+    json["type"] = conflictTypeName(type);
+    json["id"] = otherId;
+    if (!otherName.isEmpty()) {
+        json["name"] = otherName;
+    }
+    if (otherSegment >= 0) {
+        json["otherSegment"] = otherSegment;
+    }
+    json["gapMeters"] = qRound(gapMeters * 10.0) / 10.0;
+    return json;
+}
+
+CorridorIndex::CorridorIndex()
+    : m_segmentsDirty(true)
+{
+}
+
+void CorridorIndex::setZones(const QJsonObject& collection)
+{
+    m_zones.clear();
+    m_zoneIndex.clear();
+
+    const QJsonArray features = collection.value("features").toArray();
+    QVector<SpatialIndex::Entry> entries;
+    for (const QJsonValue& value : features) {
+        const QJsonObject feature = value.toObject();
+        const QJsonObject properties = feature.value("properties").toObject();
+        const QJsonObject geometry = feature.value("geometry").toObject();
+        const QString type = geometry.value("type").toString();
+
+        QJsonArray polygons;
+        if (type == "Polygon") {
+            polygons.append(geometry.value("coordinates"));
+        } else if (type == "MultiPolygon") {
+            polygons = geometry.value("coordinates").toArray();
+        } else {
+            continue;
+        }
+
+        Zone zone;
+        zone.id = feature.value("id").isDouble() ? QString::number(feature.value("id").toDouble())
+                                                 : feature.value("id").toString();
+        zone.name = properties.value("name").toString();
+        zone.clearance = qMax(0.0, properties.value("clearance").toDouble());
+        zone.minAltitude = properties.value("minAltitude").toDouble(-UNBOUNDED);
+        zone.maxAltitude = properties.value("maxAltitude").toDouble(UNBOUNDED);
+
+        // Every zone is projected around its own center
+        const BoundingBox box = BoundingBox::ofGeometry(geometry);
+        if (box.isNull()) {
+            continue;
+        }
+        zone.projection = LocalProjection(box.centerX(), box.centerY());
+        for (const QJsonValue& polygon : polygons) {
+            QVector<QPolygonF> rings;
+            for (const QJsonValue& ring : polygon.toArray()) {
+                rings.append(zone.projection.lineToMeters(ring.toArray()));
+            }
+            zone.polygons.append(rings);
+        }
+
+        SpatialIndex::Entry entry;
+        entry.box = boxAround(QPointF(box.minX, box.minY), QPointF(box.maxX, box.maxY), zone.clearance);
+        entry.value = m_zones.size();
+        entries.append(entry);
+        m_zones.append(zone);
+    }
+
+    m_zoneIndex.build(entries);
+}
+
+PositionUncertainty CorridorIndex::uncertaintyOf(const QJsonObject& pathFeature, const PositionUncertainty& fallback)
+{
+    const QJsonObject properties = pathFeature.value("properties").toObject();
+    PositionUncertainty uncertainty;
+    uncertainty.horizontalMeters = qMax(0.0, properties.value("horizontalUncertainty").toDouble(fallback.horizontalMeters));
+    uncertainty.verticalMeters = qMax(0.0, properties.value("verticalUncertainty").toDouble(fallback.verticalMeters));
+    return uncertainty;
+}
+
+void CorridorIndex::setCorridor(const QString& droneName, const QJsonObject& pathFeature,
+                                const PositionUncertainty& uncertainty)
+{
+    const QJsonObject geometry = pathFeature.value("geometry").toObject();
+    if (geometry.value("type").toString() != "LineString") {
+        removeCorridor(droneName);
+        return;
+    }
+
+    Corridor corridor;
+    corridor.coordinates = geometry.value("coordinates").toArray();
+    corridor.uncertainty = uncertainty;
+    if (corridor.coordinates.isEmpty()) {
+        removeCorridor(droneName);
+        return;
+    }
+
+    prepareCorridor(corridor);
+    m_corridors.insert(droneName, corridor);
+    m_segmentsDirty = true;
+}
+
+void CorridorIndex::removeCorridor(const QString& droneName)
+{
+    if (m_corridors.remove(droneName)) {
+        m_segmentsDirty = true;
+    }
+}
+
+QJsonObject CorridorIndex::footprint(const QString& droneName) const
+{
+    auto it = m_corridors.constFind(droneName);
+    if (it == m_corridors.constEnd()) {
+        return QJsonObject();
+    }
+
+    QJsonObject line;
+    line["type"] = "LineString";
+    line["coordinates"] = it->coordinates;
+    return PolygonClipper::buffer(line, it->uncertainty.horizontalMeters);
+}
+
+QVector<CorridorConflict> CorridorIndex::conflicts(const QString& droneName, int fromSegment,
+                                                   bool withZones, bool withCorridors) const
+{
+    QVector<CorridorConflict> result;
+    auto it = m_corridors.constFind(droneName);
+    if (it == m_corridors.constEnd()) {
+        return result;
+    }
+    if (withCorridors) {
+        ensureSegmentIndex();
+    }
+
+    const Corridor& corridor = it.value();
+    const double radius = corridor.uncertainty.horizontalMeters;
+    for (int s = qMax(0, fromSegment); s + 1 < corridor.points.size(); ++s) {
+        const QPointF& a = corridor.points[s];
+        const QPointF& b = corridor.points[s + 1];
+        const BoundingBox box = segmentBox(corridor, s);
+        double low;
+        double high;
+        segmentBand(corridor, s, low, high);
+
+        QMap<QString, CorridorConflict> closest;
+        if (withZones) {
+            for (int z : m_zoneIndex.queryBox(box)) {
+                const Zone& zone = m_zones[z];
+                if (!bandsOverlap(low, high, zone.minAltitude, zone.maxAltitude)) {
+                    continue;
+                }
+
+                const double gap = zoneDistance(zone, zone.projection.toMeters(a.x(), a.y()),
+                                                zone.projection.toMeters(b.x(), b.y())) -
+                                   radius - zone.clearance;
+                if (gap <= 0.0) {
+                    CorridorConflict conflict;
+                    conflict.droneName = droneName;
+                    conflict.segment = s;
+                    conflict.type = CorridorConflict::Zone;
+                    conflict.otherId = zone.id;
+                    conflict.otherName = zone.name;
+                    conflict.gapMeters = gap;
+                    keepClosest(closest, conflict);
+                }
+            }
+        }
+
+        if (withCorridors && s >= LAUNCH_SEGMENTS) {
+            const LocalProjection local = projectionAround(a, b);
+            const QPointF localA = local.toMeters(a.x(), a.y());
+            const QPointF localB = local.toMeters(b.x(), b.y());
+            for (int value : m_segmentIndex.queryBox(box)) {
+                const SegmentRef& ref = m_segments[value];
+                if (ref.droneName == droneName) {
+                    continue;
+                }
+
+                const Corridor& other = *m_corridors.constFind(ref.droneName);
+                double otherLow;
+                double otherHigh;
+                segmentBand(other, ref.segment, otherLow, otherHigh);
+                if (!bandsOverlap(low, high, otherLow, otherHigh)) {
+                    continue;
+                }
+
+                const QPointF& c = other.points[ref.segment];
+                const QPointF& d = other.points[ref.segment + 1];
+                const double gap = PlanarGeometry::segmentDistance(localA, localB, local.toMeters(c.x(), c.y()),
+                                                                   local.toMeters(d.x(), d.y())) -
+                                   radius - other.uncertainty.horizontalMeters;
+                if (gap <= 0.0) {
+                    CorridorConflict conflict;
+                    conflict.droneName = droneName;
+                    conflict.segment = s;
+                    conflict.type = CorridorConflict::Corridor;
+                    conflict.otherId = ref.droneName;
+                    conflict.otherSegment = ref.segment;
+                    conflict.gapMeters = gap;
+                    keepClosest(closest, conflict);
+                }
+            }
+        }
+
+        for (const CorridorConflict& conflict : closest) {
+            result.append(conflict);
+        }
+    }
+    return result;
+}
+
+QVector<CorridorConflict> CorridorIndex::positionConflicts(const QString& droneName, double lng, double lat, double alt,
+                                                           const PositionUncertainty& uncertainty) const
+{
+    ensureSegmentIndex();
+
+    // Corridors are measured around the position, it sits at the origin
+    const QPointF p(lng, lat);
+    const LocalProjection local(lng, lat);
+    const double radius = uncertainty.horizontalMeters;
+    const double low = alt - uncertainty.verticalMeters;
+    const double high = alt + uncertainty.verticalMeters;
+    const BoundingBox box = boxAround(p, p, radius);
+
+    QMap<QString, CorridorConflict> closest;
+    for (int z : m_zoneIndex.queryBox(box)) {
+        const Zone& zone = m_zones[z];
+        if (!bandsOverlap(low, high, zone.minAltitude, zone.maxAltitude)) {
+            continue;
+        }
+
+        const QPointF inZone = zone.projection.toMeters(lng, lat);
+        const double gap = zoneDistance(zone, inZone, inZone) - radius - zone.clearance;
+        if (gap <= 0.0) {
+            CorridorConflict conflict;
+            conflict.droneName = droneName;
+            conflict.type = CorridorConflict::Zone;
+            conflict.otherId = zone.id;
+            conflict.otherName = zone.name;
+            conflict.gapMeters = gap;
+            keepClosest(closest, conflict);
+        }
+    }
+
+    for (int value : m_segmentIndex.queryBox(box)) {
+        const SegmentRef& ref = m_segments[value];
+        if (ref.droneName == droneName) {
+            continue;
+        }
+
+        const Corridor& other = *m_corridors.constFind(ref.droneName);
+        double otherLow;
+        double otherHigh;
+        segmentBand(other, ref.segment, otherLow, otherHigh);
+        if (!bandsOverlap(low, high, otherLow, otherHigh)) {
+            continue;
+        }
+
+        const QPointF& c = other.points[ref.segment];
+        const QPointF& d = other.points[ref.segment + 1];
+        const double gap = PlanarGeometry::pointSegmentDistance(QPointF(0.0, 0.0), local.toMeters(c.x(), c.y()),
+                                                                local.toMeters(d.x(), d.y())) -
+                           radius - other.uncertainty.horizontalMeters;
+        if (gap <= 0.0) {
+            CorridorConflict conflict;
+            conflict.droneName = droneName;
+            conflict.type = CorridorConflict::Corridor;
+            conflict.otherId = ref.droneName;
+            conflict.otherSegment = ref.segment;
+            conflict.gapMeters = gap;
+            keepClosest(closest, conflict);
+        }
+    }
+
+    QVector<CorridorConflict> result;
+    for (const CorridorConflict& conflict : closest) {
+        result.append(conflict);
+    }
+    return result;
+}
+
+void CorridorIndex::prepareCorridor(Corridor& corridor) const
+{
+    corridor.points = PlanarGeometry::positionsToPolygon(corridor.coordinates);
+    corridor.altitudes.clear();
+
+    // Altitudes are only used when every vertex has one
+    QVector<double> altitudes;
+    altitudes.reserve(corridor.coordinates.size());
+    for (const QJsonValue& position : corridor.coordinates) {
+        const QJsonArray values = position.toArray();
+        if (values.size() < 3 || !values.at(2).isDouble()) {
+            return;
+        }
+        altitudes.append(values.at(2).toDouble());
+    }
+    corridor.altitudes = altitudes;
+}
+
+void CorridorIndex::ensureSegmentIndex() const
+{
+    if (!m_segmentsDirty) {
+        return;
+    }
+
+    QVector<SpatialIndex::Entry> entries;
+    m_segments.clear();
+    for (auto it = m_corridors.constBegin(); it != m_corridors.constEnd(); ++it) {
+        for (int s = LAUNCH_SEGMENTS; s + 1 < it->points.size(); ++s) {
+            SpatialIndex::Entry entry;
+            entry.box = segmentBox(it.value(), s);
+            entry.value = m_segments.size();
+            entries.append(entry);
+            m_segments.append(SegmentRef{it.key(), s});
+        }
+    }
+
+    m_segmentIndex.build(entries);
+    m_segmentsDirty = false;
+}
+
+void CorridorIndex::segmentBand(const Corridor& corridor, int segment, double& low, double& high) const
+{
+    if (corridor.altitudes.isEmpty()) {
+        low = -UNBOUNDED;
+        high = UNBOUNDED;
+        return;
+    }
+
+    low = qMin(corridor.altitudes[segment], corridor.altitudes[segment + 1]) - corridor.uncertainty.verticalMeters;
+    high = qMax(corridor.altitudes[segment], corridor.altitudes[segment + 1]) + corridor.uncertainty.verticalMeters;
+}
+
+BoundingBox CorridorIndex::segmentBox(const Corridor& corridor, int segment) const
+{
+    return boxAround(corridor.points[segment], corridor.points[segment + 1], corridor.uncertainty.horizontalMeters);
+}
+
+double CorridorIndex::zoneDistance(const Zone& zone, const QPointF& a, const QPointF& b) const
+{
+    double distance = UNBOUNDED;
+    for (const QVector<QPolygonF>& rings : zone.polygons) {
+        if (PlanarGeometry::ringsContain(rings, a)) {
+            return 0.0;
+        }
+        distance = qMin(distance, PlanarGeometry::segmentRingsDistance(a, b, rings));
+    }
+    return distance;
+}
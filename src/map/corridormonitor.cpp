@@ -0,0 +1,98 @@
+#include "../../include/map/corridormonitor.h"
+#include "../../include/map/shapestore.h"
+#include <QDebug>
+#include <limits>
+
+CorridorMonitor::CorridorMonitor(QObject* parent)
+    : QObject(parent)
+    , m_zonesRevision(std::numeric_limits<quint64>::max())
+{
+    // Start from the paths already published
+    UpdateBus& bus = UpdateBus::instance();
+    const QMap<QString, PathSnapshotPtr> paths = bus.latestPaths();
+    for (const PathSnapshotPtr& snapshot : paths) {
+        handlePathPublished(snapshot);
+    }
+
+    connect(&bus, &UpdateBus::pathPublished, this, &CorridorMonitor::handlePathPublished);
+    connect(&bus, &UpdateBus::fleetPublished, this, &CorridorMonitor::handleFleetPublished);
+}
+
+void CorridorMonitor::setDefaultUncertainty(const PositionUncertainty& uncertainty)
+{
+    m_defaultUncertainty = uncertainty;
+
+    // Corridors without their own uncertainty are rebuilt
+    for (const QString& droneName : m_index.droneNames()) {
+        if (!m_uncertainties.contains(droneName)) {
+            handlePathPublished(UpdateBus::instance().latestPath(droneName));
+        }
+    }
+}
+
+void CorridorMonitor::setUncertainty(const QString& droneName, const PositionUncertainty& uncertainty)
+{
+    m_uncertainties.insert(droneName, uncertainty);
+    PathSnapshotPtr snapshot = UpdateBus::instance().latestPath(droneName);
+    if (snapshot) {
+        handlePathPublished(snapshot);
+    }
+}
+
+void CorridorMonitor::handlePathPublished(PathSnapshotPtr snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
+    if (snapshot->feature.isEmpty()) {
+        m_index.removeCorridor(snapshot->droneName);
+        return;
+    }
+
+    // A drone's own setting wins over the path's properties
+    PositionUncertainty uncertainty = m_uncertainties.contains(snapshot->droneName)
+        ? m_uncertainties.value(snapshot->droneName)
+        : CorridorIndex::uncertaintyOf(snapshot->feature, m_defaultUncertainty);
+    m_index.setCorridor(snapshot->droneName, snapshot->feature, uncertainty);
+}
+
+void CorridorMonitor::handleFleetPublished(FleetSnapshotPtr snapshot)
+{
+    refreshZones();
+
+    for (const DroneState& drone : snapshot->drones) {
+        const QVector<CorridorConflict> conflicts = m_index.positionConflicts(
+            drone.id, drone.lng, drone.lat, drone.alt, uncertaintyOf(drone.id));
+
+        QJsonArray json;
+        for (const CorridorConflict& conflict : conflicts) {
+            json.append(conflict.toJson());
+        }
+
+        // Only changes are reported, not every tick
+        if (json == m_reported.value(drone.id)) {
+            continue;
+        }
+        m_reported.insert(drone.id, json);
+
+        if (!json.isEmpty()) {
+            qWarning() << "Drone" << drone.id << "has" << json.size() << "corridor conflicts";
+        }
+        emit conflictsChanged(drone.id, json);
+    }
+}
+
+PositionUncertainty CorridorMonitor::uncertaintyOf(const QString& droneName) const
+{
+    return m_uncertainties.value(droneName, m_defaultUncertainty);
+}
+
+void CorridorMonitor::refreshZones()
+{
+    // Zones are only prepared again after the shapes changed
+    ShapeStore& shapes = ShapeStore::instance();
+    if (m_zonesRevision != shapes.revision()) {
+        m_index.setZones(shapes.featureCollection());
+        m_zonesRevision = shapes.revision();
+    }
+}
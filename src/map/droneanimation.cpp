@@ -0,0 +1,145 @@
+#include "../../include/map/droneanimation.h"
+#include "../../include/map/planargeometry.h"
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+// East / north meters from one path vertex to the next, projected around
+// their middle
+QPointF segmentOffset(const QJsonArray& from, const QJsonArray& to)
+{
+    const LocalProjection projection(from[0].toDouble(), (from[1].toDouble() + to[1].toDouble()) / 2.0);
+    return projection.toMeters(to) - projection.toMeters(from);
+}
+}
+
+DroneAnimationEngine::DroneAnimationEngine(QObject* parent, int telemetryIntervalMs)
+    : QObject(parent)
+{
+    m_missionClock.start();
+
+    // One timer for the whole fleet
+    m_telemetryTimer = new QTimer(this);
+    m_telemetryTimer->setInterval(telemetryIntervalMs);
+    connect(m_telemetryTimer, &QTimer::timeout, this, &DroneAnimationEngine::tick);
+}
+
+DroneAnimationEngine::~DroneAnimationEngine()
+{
+}
+
+bool DroneAnimationEngine::startDrone(const QString& droneId, const QJsonArray& coordinates, double speedMetersPerSecond)
+{
+    if (coordinates.size() < 2 || speedMetersPerSecond <= 0.0) {
+        qDebug() << "No path to animate for drone:" << droneId;
+        return false;
+    }
+
+    Track track;
+    track.path = coordinates;
+    track.speed = speedMetersPerSecond;
+    track.startMs = m_missionClock.elapsed();
+
+    // Cumulative distance along the path, used to place the drone in time
+    track.distances.reserve(coordinates.size());
+    track.distances.append(0.0);
+    for (int i = 1; i < coordinates.size(); ++i) {
+        const QPointF offset = segmentOffset(coordinates[i - 1].toArray(), coordinates[i].toArray());
+        track.distances.append(track.distances.last() + std::hypot(offset.x(), offset.y()));
+    }
+
+    m_tracks.insert(droneId, track);
+    if (!m_telemetryTimer->isActive()) {
+        m_telemetryTimer->start();
+    }
+    return true;
+}
+
+void DroneAnimationEngine::stopDrone(const QString& droneId)
+{
+    m_tracks.remove(droneId);
+    if (m_tracks.isEmpty()) {
+        m_telemetryTimer->stop();
+    }
+}
+
+void DroneAnimationEngine::stopAll()
+{
+    m_tracks.clear();
+    m_telemetryTimer->stop();
+}
+
+void DroneAnimationEngine::tick()
+{
+    // All drones share the same timestamp and travel in one batch
+    const qint64 now = m_missionClock.elapsed();
+    QJsonArray keyframes;
+    QStringList finished;
+
+    for (auto it = m_tracks.constBegin(); it != m_tracks.constEnd(); ++it) {
+        QJsonObject keyframe = keyframeAt(it.key(), it.value(), now);
+        if (keyframe["final"].toBool()) {
+            finished.append(it.key());
+        }
+        keyframes.append(keyframe);
+    }
+
+    if (!keyframes.isEmpty()) {
+        emit keyframesReady(keyframes);
+    }
+
+    for (const QString& droneId : finished) {
+        m_tracks.remove(droneId);
+        emit droneFinished(droneId);
+    }
+
+    if (m_tracks.isEmpty()) {
+        m_telemetryTimer->stop();
+        if (!finished.isEmpty()) {
+            emit allFinished();
+        }
+    }
+}
+
+QJsonObject DroneAnimationEngine::keyframeAt(const QString& droneId, const Track& track, qint64 missionTimeMs)
+{
+    const QVector<double>& distances = track.distances;
+    double distance = track.speed * (missionTimeMs - track.startMs) / 1000.0;
+    bool finished = distance >= distances.last();
+
+    // Find the path segment the drone is on
+    int segment = int(std::upper_bound(distances.begin(), distances.end(), distance) - distances.begin());
+    segment = qBound(1, segment, distances.size() - 1);
+
+    QJsonArray from = track.path[segment - 1].toArray();
+    QJsonArray to = track.path[segment].toArray();
+    double segmentLength = distances[segment] - distances[segment - 1];
+    double t = segmentLength > 0.0 ? qBound(0.0, (distance - distances[segment - 1]) / segmentLength, 1.0) : 1.0;
+
+    double lng = from[0].toDouble() + (to[0].toDouble() - from[0].toDouble()) * t;
+    double lat = from[1].toDouble() + (to[1].toDouble() - from[1].toDouble()) * t;
+    double fromAlt = from.size() > 2 ? from[2].toDouble() : 0.0;
+    double toAlt = to.size() > 2 ? to[2].toDouble() : 0.0;
+    double alt = fromAlt + (toAlt - fromAlt) * t;
+
+    // Heading and velocity of the current segment
+    const QPointF offset = segmentOffset(from, to);
+    const double east = offset.x();
+    const double north = offset.y();
+    double heading = std::fmod(qRadiansToDegrees(std::atan2(east, north)) + 360.0, 360.0);
+    double speed = (finished || segmentLength <= 0.0) ? 0.0 : track.speed;
+
+    QJsonObject keyframe;
+    keyframe["id"] = droneId;
+    keyframe["t"] = double(missionTimeMs);
+    keyframe["p"] = QJsonArray{lng, lat, alt};
+    keyframe["h"] = heading;
+    keyframe["v"] = QJsonArray{
+        segmentLength > 0.0 ? speed * east / segmentLength : 0.0,
+        segmentLength > 0.0 ? speed * north / segmentLength : 0.0,
+        segmentLength > 0.0 ? speed * (toAlt - fromAlt) / segmentLength : 0.0
+    };
+    keyframe["final"] = finished;
+    return keyframe;
+}
@@ -0,0 +1,81 @@
+#include "../../include/map/featuredelta.h"
+
+FeatureDeltaTracker::FeatureDeltaTracker()
+    : m_nextVersion(1)
+    , m_reset(false)
+{
+}
+
+bool FeatureDeltaTracker::upsert(const QString& id, const QJsonObject& feature)
+{
+    auto it = m_features.find(id);
+    if (it != m_features.end() && it->feature == feature) {
+        return false;
+    }
+
+    Entry entry;
+    entry.feature = feature;
+    entry.version = m_nextVersion++;
+    m_features.insert(id, entry);
+
+    m_dirty.insert(id);
+    m_removed.remove(id);
+    return true;
+}
+
+void FeatureDeltaTracker::remove(const QString& id)
+{
+    if (m_features.remove(id) == 0) {
+        return;
+    }
+
+    m_dirty.remove(id);
+    m_removed.insert(id);
+}
+
+void FeatureDeltaTracker::replaceAll(const QHash<QString, QJsonObject>& features)
+{
+    const QList<QString> currentIds = m_features.keys();
+    for (const QString& id : currentIds) {
+        if (!features.contains(id)) {
+            remove(id);
+        }
+    }
+
+    for (auto it = features.constBegin(); it != features.constEnd(); ++it) {
+        upsert(it.key(), it.value());
+    }
+}
+
+QJsonObject FeatureDeltaTracker::takeDelta()
+{
+    QJsonArray upserts;
+    QJsonArray removes;
+
+    // A reset resends everything, otherwise only what changed
+    const QList<QString> ids = m_reset ? m_features.keys() : m_dirty.values();
+    for (const QString& id : ids) {
+        const Entry& entry = m_features[id];
+        QJsonObject upsertObj;
+        upsertObj["id"] = id;
+        upsertObj["version"] = double(entry.version);
+        upsertObj["feature"] = entry.feature;
+        upserts.append(upsertObj);
+    }
+
+    if (!m_reset) {
+        for (const QString& id : m_removed) {
+            removes.append(id);
+        }
+    }
+
+    QJsonObject delta;
+    delta["reset"] = m_reset;
+    delta["upsert"] = upserts;
+    delta["remove"] = removes;
+
+    m_dirty.clear();
+    m_removed.clear();
+    m_reset = false;
+    return delta;
+}
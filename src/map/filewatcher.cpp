@@ -0,0 +1,108 @@
+#include "../../include/map/filewatcher.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+FileWatcher::FileWatcher(QObject* parent, int debounceMs)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounceTimer(new QTimer(this))
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(debounceMs);
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &FileWatcher::handleFileChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &FileWatcher::handleDirectoryChanged);
+    connect(m_debounceTimer, &QTimer::timeout, this, &FileWatcher::flushChanges);
+}
+
+void FileWatcher::watchFile(const QString& filePath)
+{
+    QString absolutePath = QFileInfo(filePath).absoluteFilePath();
+
+    // Watch the directory so the file is noticed when it is (re)created
+    QString directoryPath = QFileInfo(absolutePath).absolutePath();
+    QDir().mkpath(directoryPath);
+    if (!m_watcher->directories().contains(directoryPath)) {
+        m_watcher->addPath(directoryPath);
+    }
+
+    m_files.insert(absolutePath, currentState(absolutePath));
+    ensureWatched(absolutePath);
+}
+
+void FileWatcher::unwatchFile(const QString& filePath)
+{
+    QString absolutePath = QFileInfo(filePath).absoluteFilePath();
+    m_files.remove(absolutePath);
+    m_pendingFiles.remove(absolutePath);
+    m_watcher->removePath(absolutePath);
+}
+
+void FileWatcher::handleFileChanged(const QString& filePath)
+{
+    if (!m_files.contains(filePath)) {
+        return;
+    }
+
+    // Editors and QSaveFile replace the file, which drops the inotify watch
+    ensureWatched(filePath);
+    m_pendingFiles.insert(filePath);
+    m_debounceTimer->start();
+}
+
+void FileWatcher::handleDirectoryChanged(const QString& directoryPath)
+{
+    // A file in the directory was created, removed or renamed
+    for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+        if (QFileInfo(it.key()).absolutePath() == directoryPath) {
+            ensureWatched(it.key());
+            m_pendingFiles.insert(it.key());
+        }
+    }
+
+    if (!m_pendingFiles.isEmpty()) {
+        m_debounceTimer->start();
+    }
+}
+
+void FileWatcher::flushChanges()
+{
+    QStringList changedFiles;
+    for (const QString& filePath : m_pendingFiles) {
+        auto it = m_files.find(filePath);
+        if (it == m_files.end()) {
+            continue;
+        }
+
+        // Skip events that did not change the contents (e.g. sibling files)
+        FileState state = currentState(filePath);
+        if (state.lastModified != it->lastModified || state.size != it->size) {
+            it.value() = state;
+            changedFiles.append(filePath);
+        }
+    }
+    m_pendingFiles.clear();
+
+    if (!changedFiles.isEmpty()) {
+        emit filesChanged(changedFiles);
+    }
+}
+
+FileWatcher::FileState FileWatcher::currentState(const QString& filePath) const
+{
+    FileState state;
+    QFileInfo fileInfo(filePath);
+    if (fileInfo.exists()) {
+        state.lastModified = fileInfo.lastModified();
+        state.size = fileInfo.size();
+    }
+    return state;
+}
+
+void FileWatcher::ensureWatched(const QString& filePath)
+{
+    if (QFileInfo::exists(filePath) && !m_watcher->files().contains(filePath)) {
+        m_watcher->addPath(filePath);
+    }
+}
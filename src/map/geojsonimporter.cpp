@@ -0,0 +1,310 @@
+#include "../../include/map/geojsonimporter.h"
+#include "../../include/map/maplod.h"
+#include "../../include/map/shapestore.h"
+#include <QtConcurrent>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDebug>
+
+namespace {
+const qint64 READ_CHUNK_BYTES = 1 << 20;
+// The map draws imported shapes with the detail visible at this zoom band
+const int RENDER_BAND = 12;
+
+// Splits a byte stream into the JSON text of single features: the elements
+// of a "features" array, or every top level object of a sequence. Only the
+// feature being scanned is kept in memory.
+class FeatureScanner
+{
+public:
+    void feed(const QByteArray& chunk, QVector<QByteArray>& features)
+    {
+        m_buffer.append(chunk);
+
+        const char* data = m_buffer.constData();
+        const int size = m_buffer.size();
+        for (int i = m_pos; i < size; ++i) {
+            const char c = data[i];
+
+            if (m_inString) {
+                if (m_escaped) {
+                    m_escaped = false;
+                } else if (c == '\\') {
+                    m_escaped = true;
+                } else if (c == '"') {
+                    m_inString = false;
+                    // Remember the last key of the top level object
+                    if (m_depth == 1) {
+                        m_lastKey = m_buffer.mid(m_stringStart + 1, i - m_stringStart - 1);
+                    }
+                }
+                continue;
+            }
+
+            switch (c) {
+            case '"':
+                m_inString = true;
+                m_stringStart = i;
+                break;
+            case '{':
+                if (m_depth == 0) {
+                    m_topStart = i;
+                    m_sawFeatures = false;
+                } else if (m_depth == m_featuresDepth) {
+                    m_featureStart = i;
+                }
+                m_depth++;
+                break;
+            case '[':
+                // A bare top level array is read like a "features" array
+                if (m_depth == 0 || (m_depth == 1 && m_lastKey == "features")) {
+                    m_featuresDepth = m_depth + 1;
+                    m_sawFeatures = true;
+                }
+                m_depth++;
+                break;
+            case '}':
+                m_depth--;
+                if (m_depth == m_featuresDepth && m_featureStart >= 0) {
+                    features.append(m_buffer.mid(m_featureStart, i - m_featureStart + 1));
+                    m_featureStart = -1;
+                } else if (m_depth == 0) {
+                    // A sequence record, unless it was a collection already split
+                    if (!m_sawFeatures && m_topStart >= 0) {
+                        features.append(m_buffer.mid(m_topStart, i - m_topStart + 1));
+                    }
+                    m_topStart = -1;
+                    m_lastKey.clear();
+                }
+                break;
+            case ']':
+                if (m_depth == m_featuresDepth) {
+                    m_featuresDepth = -1;
+                }
+                m_depth--;
+                break;
+            default:
+                break;
+            }
+        }
+        m_pos = size;
+
+        // Drop what was scanned and is not part of an unfinished record
+        int keep = m_pos;
+        if (m_featureStart >= 0) {
+            keep = m_featureStart;
+        } else if (m_topStart >= 0 && !m_sawFeatures) {
+            keep = m_topStart;
+        }
+        if (m_inString) {
+            keep = qMin(keep, m_stringStart);
+        }
+        if (keep > 0) {
+            m_buffer.remove(0, keep);
+            m_pos -= keep;
+            m_stringStart -= keep;
+            if (m_featureStart >= 0) {
+                m_featureStart -= keep;
+            }
+            if (m_topStart >= 0) {
+                m_topStart = m_sawFeatures ? 0 : m_topStart - keep;
+            }
+        }
+    }
+
+    // True when the input ended inside a record
+    bool isIncomplete() const { return m_depth != 0 || m_inString; }
+
+private:
+    QByteArray m_buffer;
+    QByteArray m_lastKey;
+    int m_pos = 0;
+    int m_depth = 0;
+    int m_featuresDepth = -1;
+    int m_topStart = -1;
+    int m_featureStart = -1;
+    int m_stringStart = -1;
+    bool m_inString = false;
+    bool m_escaped = false;
+    bool m_sawFeatures = false;
+};
+
+bool isGeometryType(const QString& type)
+{
+    return type == "Point" || type == "MultiPoint" || type == "LineString" || type == "MultiLineString" ||
+           type == "Polygon" || type == "MultiPolygon" || type == "GeometryCollection";
+}
+
+QJsonArray simplifyRings(const QJsonArray& rings, double toleranceMeters, int minimumPositions)
+{
+    QJsonArray simplified;
+    for (const QJsonValue& ring : rings) {
+        QJsonArray positions = MapLevelOfDetail::simplifyLine(ring.toArray(), toleranceMeters);
+        // A ring reduced below a triangle is drawn as it was
+        simplified.append(positions.size() >= minimumPositions ? positions : ring.toArray());
+    }
+    return simplified;
+}
+}
+
+GeoJsonImporter::GeoJsonImporter(QObject* parent)
+    : QObject(parent)
+    , m_cancelled(0)
+{
+    connect(&m_watcher, &QFutureWatcher<ReadResult>::finished, this, &GeoJsonImporter::handleReadFinished);
+}
+
+GeoJsonImporter::~GeoJsonImporter()
+{
+    cancel();
+    m_watcher.waitForFinished();
+}
+
+bool GeoJsonImporter::start(const QString& filePath, const QString& shapeName)
+{
+    if (isRunning()) {
+        qWarning() << "A GeoJSON import is already running";
+        return false;
+    }
+
+    const QString name = shapeName.isEmpty() ? QFileInfo(filePath).completeBaseName() : shapeName;
+    m_cancelled = 0;
+    m_watcher.setFuture(QtConcurrent::run([this, filePath, name]() {
+        return read(filePath, name);
+    }));
+    return true;
+}
+
+void GeoJsonImporter::cancel()
+{
+    m_cancelled = 1;
+}
+
+void GeoJsonImporter::handleReadFinished()
+{
+    ReadResult result = m_watcher.result();
+    if (!result.error.isEmpty()) {
+        qWarning() << "GeoJSON import failed:" << result.error;
+        emit finished(0, result.error);
+        return;
+    }
+
+    // One bulk insert and one snapshot for the whole file
+    ShapeStore::instance().importShapes(result.features, result.boxes, result.rendered);
+    qDebug() << "Imported" << result.features.size() << "shapes," << result.skipped << "records skipped";
+    emit finished(result.features.size(), QString());
+}
+
+GeoJsonImporter::ReadResult GeoJsonImporter::read(const QString& filePath, const QString& shapeName)
+{
+    ReadResult result;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.error = QString("Cannot open %1: %2").arg(filePath, file.errorString());
+        return result;
+    }
+
+    const qint64 totalBytes = file.size();
+    qint64 bytesRead = 0;
+    FeatureScanner scanner;
+    QVector<QByteArray> records;
+
+    while (!file.atEnd()) {
+        if (m_cancelled.loadAcquire()) {
+            result.error = "Import cancelled";
+            return result;
+        }
+
+        QByteArray chunk = file.read(READ_CHUNK_BYTES);
+        if (chunk.isEmpty()) {
+            break;
+        }
+        bytesRead += chunk.size();
+
+        records.clear();
+        scanner.feed(chunk, records);
+        for (const QByteArray& record : records) {
+            QJsonParseError parseError;
+            const QJsonObject object = QJsonDocument::fromJson(record, &parseError).object();
+            if (parseError.error != QJsonParseError::NoError) {
+                result.skipped++;
+                continue;
+            }
+
+            // Sequence records may be features, bare geometries or small collections
+            QJsonArray features;
+            const QString type = object.value("type").toString();
+            if (type == "Feature") {
+                features.append(object);
+            } else if (type == "FeatureCollection") {
+                features = object.value("features").toArray();
+            } else if (isGeometryType(type)) {
+                features.append(QJsonObject{{"type", "Feature"}, {"properties", QJsonObject()}, {"geometry", object}});
+            } else {
+                result.skipped++;
+                continue;
+            }
+
+            for (const QJsonValue& value : features) {
+                QJsonObject feature = value.toObject();
+                const BoundingBox box = BoundingBox::ofGeometry(feature.value("geometry").toObject());
+                if (box.isNull()) {
+                    result.skipped++;
+                    continue;
+                }
+
+                QJsonObject props = feature.value("properties").toObject();
+                if (!props.contains("name")) {
+                    props["name"] = shapeName;
+                    feature["properties"] = props;
+                }
+
+                result.features.append(feature);
+                result.boxes.append(box);
+                result.rendered.append(simplifiedFeature(feature, box));
+            }
+        }
+
+        emit progress(bytesRead, totalBytes, result.features.size());
+    }
+
+    if (scanner.isIncomplete()) {
+        qWarning() << "GeoJSON file ends inside a record:" << filePath;
+    }
+    if (result.features.isEmpty() && result.skipped > 0) {
+        result.error = QString("No valid features in %1").arg(filePath);
+    }
+    return result;
+}
+
+QJsonObject GeoJsonImporter::simplifiedFeature(const QJsonObject& feature, const BoundingBox& box)
+{
+    const QJsonObject geometry = feature.value("geometry").toObject();
+    const QString type = geometry.value("type").toString();
+    const QJsonArray coordinates = geometry.value("coordinates").toArray();
+    const double tolerance = MapLevelOfDetail::toleranceForBand(RENDER_BAND, box.centerY());
+
+    QJsonArray simplified;
+    if (type == "Polygon") {
+        simplified = simplifyRings(coordinates, tolerance, 4);
+    } else if (type == "MultiPolygon") {
+        for (const QJsonValue& polygon : coordinates) {
+            simplified.append(simplifyRings(polygon.toArray(), tolerance, 4));
+        }
+    } else if (type == "LineString") {
+        simplified = MapLevelOfDetail::simplifyLine(coordinates, tolerance);
+    } else if (type == "MultiLineString") {
+        simplified = simplifyRings(coordinates, tolerance, 2);
+    } else {
+        return feature;
+    }
+
+    QJsonObject rendered = feature;
+    QJsonObject renderedGeometry = geometry;
+    renderedGeometry["coordinates"] = simplified;
+    rendered["geometry"] = renderedGeometry;
+    return rendered;
+}
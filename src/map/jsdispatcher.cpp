@@ -0,0 +1,72 @@
+#include "../../include/map/jsdispatcher.h"
+
+const int JsDispatcher::FRAME_INTERVAL_MS;
+
+JsDispatcher* JsDispatcher::forView(QWebEngineView* view)
+{
+    JsDispatcher* dispatcher = view->findChild<JsDispatcher*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!dispatcher) {
+        dispatcher = new JsDispatcher(view);
+    }
+    return dispatcher;
+}
+
+JsDispatcher::JsDispatcher(QWebEngineView* view)
+    : QObject(view)
+    , m_view(view)
+    , m_replaced(0)
+{
+    // Started by the first call of a frame, not restarted by later ones
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FRAME_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &JsDispatcher::flush);
+}
+
+void JsDispatcher::call(const QString& script)
+{
+    call(QString(), script);
+}
+
+void JsDispatcher::call(const QString& key, const QString& script)
+{
+    if (!key.isEmpty()) {
+        auto it = m_keyIndex.find(key);
+        if (it != m_keyIndex.end()) {
+            m_pending[it.value()].script.clear();
+            m_replaced++;
+            it.value() = m_pending.size();
+        } else {
+            m_keyIndex.insert(key, m_pending.size());
+        }
+    }
+
+    m_pending.append({key, script});
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void JsDispatcher::flush()
+{
+    m_flushTimer->stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    QString combined;
+    for (const PendingCall& pending : qAsConst(m_pending)) {
+        if (pending.script.isEmpty()) {
+            continue;
+        }
+        combined += QStringLiteral("try {\n");
+        combined += pending.script;
+        combined += QStringLiteral("\n} catch (e) { console.error(e); }\n");
+    }
+
+    m_pending.clear();
+    m_keyIndex.clear();
+    m_replaced = 0;
+
+    m_view->page()->runJavaScript(combined);
+}
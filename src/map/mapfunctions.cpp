@@ -1,107 +1,332 @@
 #include "../../include/map/mapfunctions.h"
+#include "../../include/drone/FleetPathStore.h"
+#include "../../include/map/coordinatecodec.h"
+#include "../../include/map/jsdispatcher.h"
+#include "../../include/map/shapestore.h"
 
 MapFunctions::MapFunctions(QWebEngineView* webView, QObject* parent)
     : QObject(parent)
     , m_webView(webView)
-    , m_lastGeojsonHash("")
+    , m_js(JsDispatcher::forView(webView))
     , m_lastGeojsonPath("")
     , m_activeDroneName("Atlas")
-    , m_currentPathIndex(0)
-    , m_animationSpeed(1.0)
-    , m_isAnimating(false)
+    , m_zoomBand(14)
+    , m_trailMaxPoints(300)
+    , m_trailMaxSeconds(0)
 {
     // Initialize drone path colors
     m_dronePathColors["Atlas"] = "#FF5733";    // Bright red/orange
     m_dronePathColors["Bolt"] = "#33A8FF";     // Bright blue
     m_dronePathColors["Barbarian"] = "#33FF57"; // Bright green
     
-    // Initialize animation timer
-    m_animationTimer = new QTimer(this);
-    connect(m_animationTimer, &QTimer::timeout, this, &MapFunctions::updateDronePosition);
+    // One engine animates the whole fleet on a clock shared with the page
+    m_animationEngine = new DroneAnimationEngine(this);
+    connect(m_animationEngine, &DroneAnimationEngine::keyframesReady, this, &MapFunctions::pushDroneKeyframes);
+    connect(m_animationEngine, &DroneAnimationEngine::allFinished, this, &MapFunctions::droneAnimationCompleted);
+    
+    // Path bursts (e.g. a fleet reply) are pushed to the page once
+    m_pathRefreshTimer = new QTimer(this);
+    m_pathRefreshTimer->setSingleShot(true);
+    m_pathRefreshTimer->setInterval(16);
+    connect(m_pathRefreshTimer, &QTimer::timeout, this, &MapFunctions::refreshDronePaths);
+    
+    // Subscribe to in-process updates, starting from what was already published
+    UpdateBus& bus = UpdateBus::instance();
+    const QMap<QString, PathSnapshotPtr> paths = bus.latestPaths();
+    for (const PathSnapshotPtr& snapshot : paths) {
+        m_dronePaths.insert(snapshot->droneName, snapshot->feature);
+    }
+    m_dirtyPaths = QSet<QString>::fromList(m_dronePaths.keys());
+    
+    // Shape edits are published as changes, start from the store's current set
+    ShapeStore& shapes = ShapeStore::instance();
+    for (const QString& id : shapes.shapeIds()) {
+        m_shapeFeatures.upsert(id, shapes.shape(id));
+    }
+    
+    connect(&bus, &UpdateBus::pathPublished, this, &MapFunctions::handlePathPublished);
+    connect(&bus, &UpdateBus::shapesPublished, this, &MapFunctions::handleShapesPublished);
+    connect(&bus, &UpdateBus::shapeChangesPublished, this, &MapFunctions::handleShapeChangesPublished);
+    connect(&bus, &UpdateBus::positionsPublished, this, &MapFunctions::handlePositionsPublished);
+    connect(&bus, &UpdateBus::fleetPublished, this, &MapFunctions::handleFleetPublished);
+    
+    // Feature stores live in the page, refill them after every (re)load
+    connect(m_webView, &QWebEngineView::loadFinished, this, &MapFunctions::handlePageLoaded);
 }
 
-void MapFunctions::setDronePositions(const QVector<QVector3D>& positions)
+void MapFunctions::handlePathPublished(PathSnapshotPtr snapshot)
 {
-    // Update positions in map view
-    QJsonArray droneArray;
-    for (const QVector3D& pos : positions) {
-        QJsonObject drone;
-        drone["x"] = pos.x();
-        drone["y"] = pos.y();
-        drone["z"] = pos.z();
-        droneArray.append(drone);
+    if (snapshot->feature.isEmpty()) {
+        m_dronePaths.remove(snapshot->droneName);
+    } else {
+        m_dronePaths.insert(snapshot->droneName, snapshot->feature);
     }
     
-    QJsonDocument doc(droneArray);
-    QString jsonString = doc.toJson(QJsonDocument::Compact);
+    m_lod.removePath(snapshot->droneName);
+    m_dirtyPaths.insert(snapshot->droneName);
+    m_pathRefreshTimer->start();
+}
+
+void MapFunctions::handleShapesPublished(ShapesSnapshotPtr snapshot)
+{
+    Q_UNUSED(snapshot);
+    
+    // Key shapes by their store id so only edited shapes are sent, ids do
+    // not shift when another shape is deleted
+    ShapeStore& store = ShapeStore::instance();
+    QHash<QString, QJsonObject> shapes;
+    for (const QString& id : store.shapeIds()) {
+        shapes.insert(id, store.shape(id));
+    }
     
-    QString script = QString("updateDronePositions(%1);").arg(jsonString);
-    m_webView->page()->runJavaScript(script);
+    m_shapeFeatures.replaceAll(shapes);
+    pushFeatureDelta("geometric-shapes", m_shapeFeatures);
 }
 
-void MapFunctions::updateDronePath(const QJsonObject& geojsonData)
+void MapFunctions::handleShapeChangesPublished(ShapeChangesPtr changes)
 {
-    // Process the features to ensure active drone is highlighted
-    QJsonObject processedData = geojsonData;
+    // Only the edited shapes go to the page, whatever the size of the set
+    for (auto it = changes->upserted.constBegin(); it != changes->upserted.constEnd(); ++it) {
+        m_shapeFeatures.upsert(it.key(), it.value());
+    }
+    for (const QString& id : changes->removed) {
+        m_shapeFeatures.remove(id);
+    }
+    pushFeatureDelta("geometric-shapes", m_shapeFeatures);
+}
+
+void MapFunctions::handlePositionsPublished(PositionsSnapshotPtr snapshot)
+{
+    setDronePositions(snapshot->positions);
+}
+
+void MapFunctions::handleFleetPublished(FleetSnapshotPtr snapshot)
+{
+    setFleetStates(snapshot->drones);
+}
+
+void MapFunctions::handlePageLoaded(bool ok)
+{
+    if (!ok) {
+        return;
+    }
+    
+    // A fresh page has empty stores, send everything once
+    m_pathFeatures.resync();
+    m_shapeFeatures.resync();
+    pushFeatureDelta("drone-path", m_pathFeatures);
+    pushFeatureDelta("geometric-shapes", m_shapeFeatures);
     
-    if (processedData.contains("features") && processedData["features"].isArray()) {
-        QJsonArray features = processedData["features"].toArray();
+    // Keyframes are stamped with the mission clock, align the page with it
+    syncMissionClock();
+    
+    // The fleet overlay starts empty, register every drone again
+    setTrailLength(m_trailMaxPoints, m_trailMaxSeconds);
+    m_fleetSlots.clear();
+    m_freeFleetSlots.clear();
+    FleetSnapshotPtr fleet = UpdateBus::instance().latestFleet();
+    if (fleet) {
+        setFleetStates(fleet->drones);
+    }
+}
+
+void MapFunctions::refreshDronePaths()
+{
+    // Only drones that changed since the last refresh are decorated and diffed
+    for (const QString& droneName : qAsConst(m_dirtyPaths)) {
+        if (m_dronePaths.contains(droneName)) {
+            QJsonObject feature = decoratePathFeature(m_dronePaths.value(droneName));
+            m_pathFeatures.upsert(droneName, m_lod.pathForBand(droneName, feature, m_zoomBand));
+        } else {
+            m_lod.removePath(droneName);
+            m_pathFeatures.remove(droneName);
+        }
+    }
+    m_dirtyPaths.clear();
+    
+    pushFeatureDelta("drone-path", m_pathFeatures);
+}
+
+void MapFunctions::pushFeatureDelta(const QString& sourceId, FeatureDeltaTracker& tracker)
+{
+    if (!tracker.hasPendingChanges()) {
+        return;
+    }
+    
+    QJsonObject delta = tracker.takeDelta();
+    
+    // Send coordinates as packed buffers rather than JSON number lists
+    QJsonArray upserts = delta.value("upsert").toArray();
+    for (int i = 0; i < upserts.size(); ++i) {
+        QJsonObject entry = upserts[i].toObject();
+        entry["feature"] = CoordinateCodec::packFeature(entry.value("feature").toObject());
+        upserts[i] = entry;
+    }
+    delta["upsert"] = upserts;
+    
+    QString deltaJson = CoordinateCodec::scriptStringLiteral(delta);
+    QString script = QString("if (window.applyFeatureDelta) { window.applyFeatureDelta('%1', %2); }")
+                         .arg(sourceId, deltaJson);
+    m_js->call(script);
+}
+
+QJsonObject MapFunctions::decoratePathFeature(QJsonObject feature)
+{
+    if (!feature.contains("properties") || !feature["properties"].isObject()) {
+        return feature;
+    }
+    
+    QJsonObject props = feature["properties"].toObject();
+    
+    // Check if this is a drone path
+    if (props.contains("name")) {
+        QString droneName = props["name"].toString();
         
-        // Process each feature to ensure proper properties
-        for (int i = 0; i < features.size(); ++i) {
-            QJsonObject feature = features[i].toObject();
-            
-            if (feature.contains("properties") && feature["properties"].isObject()) {
-                QJsonObject props = feature["properties"].toObject();
-                
-                // Check if this is a drone path
-                if (props.contains("name")) {
-                    QString droneName = props["name"].toString();
-                    
-                    // Set active flag based on current active drone
-                    props["active"] = (droneName == m_activeDroneName);
-                    
-                    // Ensure color property exists
-                    if (!props.contains("color")) {
-                        // Generate a consistent color based on drone name if not already defined
-                        QStringList colors = {"#ff0000", "#00ff00", "#0000ff", "#ffff00", "#ff00ff", "#00ffff"};
-                        int colorIndex = qHash(droneName) % colors.size();
-                        props["color"] = colors[colorIndex];
-                    }
-                    
-                    // Store color in our map for consistency
-                    m_dronePathColors[droneName] = props["color"].toString();
-                    
-                    feature["properties"] = props;
-                    features[i] = feature;
-                }
-            }
+        // Set active flag based on current active drone
+        props["active"] = (droneName == m_activeDroneName);
+        
+        // Ensure color property exists
+        if (!props.contains("color")) {
+            // Generate a consistent color based on drone name if not already defined
+            QStringList colors = {"#ff0000", "#00ff00", "#0000ff", "#ffff00", "#ff00ff", "#00ffff"};
+            int colorIndex = qHash(droneName) % colors.size();
+            props["color"] = colors[colorIndex];
         }
         
-        processedData["features"] = features;
+        // Store color in our map for consistency
+        m_dronePathColors[droneName] = props["color"].toString();
+        
+        feature["properties"] = props;
+    }
+    return feature;
+}
+
+void MapFunctions::setZoomBand(int band)
+{
+    if (band == m_zoomBand) {
+        return;
+    }
+    m_zoomBand = band;
+    
+    // Only paths whose decimated geometry differs end up in the delta
+    for (auto it = m_dronePaths.constBegin(); it != m_dronePaths.constEnd(); ++it) {
+        m_dirtyPaths.insert(it.key());
     }
+    refreshDronePaths();
     
-    // Convert to JSON string
-    QJsonDocument doc(processedData);
-    QString jsonString = doc.toJson(QJsonDocument::Compact);
+    if (!m_lastPositions.isEmpty()) {
+        setDronePositions(m_lastPositions);
+    }
+}
+
+void MapFunctions::setDronePositions(const QVector<QVector3D>& positions)
+{
+    m_lastPositions = positions;
     
-    // Calculate hash to avoid unnecessary updates
-    QString newHash = QString(QCryptographicHash::hash(jsonString.toUtf8(), QCryptographicHash::Md5).toHex());
+    // Update positions in map view as packed Float32 x, y, z, count records,
+    // drones close together on screen are merged at low zoom
+    const QVector<MapLevelOfDetail::Cluster> clusters = MapLevelOfDetail::clusterPositions(positions, m_zoomBand);
+    QVector<float> values;
+    values.reserve(clusters.size() * 4);
+    for (const MapLevelOfDetail::Cluster& cluster : clusters) {
+        values << float(cluster.lng) << float(cluster.lat) << float(cluster.alt) << float(cluster.count);
+    }
     
-    // Only update if content has changed
-    if (newHash != m_lastGeojsonHash) {
-        QString script = QString("updateDronePath(%1);").arg(jsonString);
-        m_webView->page()->runJavaScript(script, [](const QVariant &result) {
-            qDebug() << "Map updated with drone paths";
-        });
-        
-        m_lastGeojsonHash = newHash;
+    QString packed = CoordinateCodec::packFloat32(values);
+    QString script = QString("if (window.updateDronePositions) { window.updateDronePositions('%1', 4); }").arg(packed);
+    m_js->call("updateDronePositions", script);
+}
+
+void MapFunctions::setFleetStates(const QVector<DroneState>& drones)
+{
+    // Drones keep their slot while they are reported, only new and removed
+    // drones change the features the page holds
+    QJsonArray added;
+    QSet<QString> reported;
+    reported.reserve(drones.size());
+    
+    QVector<double> values;
+    values.reserve(drones.size() * 6);
+    for (const DroneState& drone : drones) {
+        reported.insert(drone.id);
+        auto slot = m_fleetSlots.constFind(drone.id);
+        if (slot == m_fleetSlots.constEnd()) {
+            int newSlot = m_freeFleetSlots.isEmpty() ? m_fleetSlots.size() : m_freeFleetSlots.takeLast();
+            slot = m_fleetSlots.insert(drone.id, newSlot);
+            added.append(QJsonObject{{"slot", newSlot}, {"id", drone.id}});
+        }
+        values << double(slot.value()) << drone.lng << drone.lat << drone.alt
+               << double(drone.heading) << double(drone.status);
+    }
+    
+    // Drones no longer reported are taken off the map
+    QJsonArray removed;
+    if (reported.size() != m_fleetSlots.size()) {
+        for (auto it = m_fleetSlots.begin(); it != m_fleetSlots.end();) {
+            if (reported.contains(it.key())) {
+                ++it;
+                continue;
+            }
+            removed.append(it.value());
+            m_freeFleetSlots.append(it.value());
+            it = m_fleetSlots.erase(it);
+        }
+    }
+    
+    if (!added.isEmpty() || !removed.isEmpty()) {
+        QString script = QString("if (window.registerFleetDrones) { window.registerFleetDrones(%1, %2); }")
+                             .arg(QString(QJsonDocument(added).toJson(QJsonDocument::Compact)),
+                                  QString(QJsonDocument(removed).toJson(QJsonDocument::Compact)));
+        m_js->call(script);
+    }
+    
+    // Packed Float64 slot, lng, lat, alt, heading, status records, Float32
+    // would quantise positions to about a meter
+    QString packed = CoordinateCodec::packFloat64(values);
+    QString script = QString("if (window.updateFleetStates) { window.updateFleetStates('%1', 6); }").arg(packed);
+    m_js->call("updateFleetStates", script);
+}
+
+void MapFunctions::setTrailLength(int maxPoints, int maxSeconds)
+{
+    m_trailMaxPoints = qMax(2, maxPoints);
+    m_trailMaxSeconds = qMax(0, maxSeconds);
+    
+    // Trails are recorded by the page from the fleet updates it already gets
+    QString script = QString("if (window.configureTrails) { window.configureTrails(%1, %2); }")
+                         .arg(m_trailMaxPoints)
+                         .arg(m_trailMaxSeconds);
+    m_js->call("configureTrails", script);
+}
+
+void MapFunctions::updateDronePath(const QJsonObject& geojsonData)
+{
+    // Paths are only drawn, the store publishes them without writing them
+    // to disk; the bus brings them back to the page with every other path
+    FleetPathStore& store = FleetPathStore::instance();
+    const QJsonArray features = geojsonData.value("features").toArray();
+    for (const QJsonValue& value : features) {
+        const QJsonObject feature = value.toObject();
+        const QJsonObject properties = feature.value("properties").toObject();
+        QString droneName = properties.value("drone").toString();
+        if (droneName.isEmpty()) {
+            droneName = properties.value("name").toString();
+        }
+        if (droneName.isEmpty()) {
+            qWarning() << "Skipping drone path without a drone or name property";
+            continue;
+        }
+        store.showPath(droneName, feature);
     }
 }
 
 void MapFunctions::setActiveDrone(const QString& droneName)
 {
     qDebug() << "Setting active drone to:" << droneName;
+    
+    // Only the previous and the new active path change their active flag
+    m_dirtyPaths.insert(m_activeDroneName);
+    m_dirtyPaths.insert(droneName);
     m_activeDroneName = droneName;
     
     // Initialize drone path colors if not already set
@@ -124,8 +349,7 @@ void MapFunctions::setActiveDrone(const QString& droneName)
         qDebug() << "Assigned random color to drone:" << droneName << "-" << randomColor.name();
     }
     
-    // Trigger a check for file changes to update the display
-    checkForFileChanges();
+    refreshDronePaths();
 }
 
 void MapFunctions::checkForFileChanges()
@@ -140,97 +364,66 @@ void MapFunctions::checkForFileChanges()
         return; // No files to check yet
     }
     
-    // Path to the main drone paths file
-    QString dronePathsFilePath = geojsonDirectory + "/all_drone_paths.geojson";
-    QFileInfo dronePathsFileInfo(dronePathsFilePath);
-    
-    // Check if the main file exists and has been modified
-    if (dronePathsFileInfo.exists() && dronePathsFileInfo.isFile()) {
-        QDateTime lastModifiedTime = dronePathsFileInfo.lastModified();
-        
-        // Reload the file if it has been modified since the last check
-        if (!m_lastDronePathsFileModified.isValid() || lastModifiedTime > m_lastDronePathsFileModified) {
-            QFile file(dronePathsFilePath);
-            if (file.open(QIODevice::ReadOnly)) {
-                QJsonDocument jsonDocument = QJsonDocument::fromJson(file.readAll());
-                QJsonObject geoJsonObject = jsonDocument.object();
-                file.close();
-                
-                // Update the map with the drone paths
-                updateDronePath(geoJsonObject);
-                
-                // Update the last modified time
-                m_lastDronePathsFileModified = lastModifiedTime;
-            }
-        }
-    } else if (!dronePathsFileInfo.exists()) {
-        // Create an empty GeoJSON file if it doesn't exist
-        QFile file(dronePathsFilePath);
-        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QJsonObject emptyGeoJsonObject;
-            emptyGeoJsonObject["type"] = "FeatureCollection";
-            emptyGeoJsonObject["features"] = QJsonArray();
-            
-            QJsonDocument jsonDocument(emptyGeoJsonObject);
-            file.write(jsonDocument.toJson());
-            file.close();
-            
-            // Set the initial last modified time
-            m_lastDronePathsFileModified = QFileInfo(dronePathsFilePath).lastModified();
-        }
-    }
+    // Drone paths arrive through the UpdateBus, push any pending ones
+    refreshDronePaths();
     
     // Check for changes in the geometric shapes file
     loadGeometricShapes();
 }
 
-void MapFunctions::updateDronePosition()
+void MapFunctions::startDroneAnimation(const QString& droneName, double speedMetersPerSecond)
 {
-    if (!m_isAnimating || m_currentPath.isEmpty() || m_currentPathIndex >= m_currentPath.size()) {
-        m_animationTimer->stop();
-        m_isAnimating = false;
-        emit droneAnimationCompleted();
-        return;
+    QJsonObject geometry = m_dronePaths.value(droneName).value("geometry").toObject();
+    if (m_animationEngine->startDrone(droneName, geometry["coordinates"].toArray(), speedMetersPerSecond)) {
+        syncMissionClock();
     }
-    
-    // Get the current coordinates
-    QJsonArray coordArray = m_currentPath[m_currentPathIndex].toArray();
-    if (coordArray.size() < 2) {
-        qDebug() << "Invalid coordinate format";
-        m_animationTimer->stop();
-        m_isAnimating = false;
-        return;
-    }
-    
-    // Extract coordinates
-    double lng = coordArray[0].toDouble();
-    double lat = coordArray[1].toDouble();
-    
-    // Create a JavaScript array of coordinates for the path
-    QString coordsJson = "[";
-    for (int i = 0; i < m_currentPath.size(); ++i) {
-        QJsonArray point = m_currentPath[i].toArray();
-        if (i > 0) coordsJson += ",";
-        coordsJson += "[" + QString::number(point[0].toDouble()) + "," + QString::number(point[1].toDouble()) + "]";
+}
+
+void MapFunctions::startFleetAnimation(const QStringList& droneNames, double speedMetersPerSecond)
+{
+    for (const QString& droneName : droneNames) {
+        QJsonObject geometry = m_dronePaths.value(droneName).value("geometry").toObject();
+        m_animationEngine->startDrone(droneName, geometry["coordinates"].toArray(), speedMetersPerSecond);
     }
-    coordsJson += "]";
-    
-    // Call JavaScript function to move the drone
-    QString script = QString("if (typeof window.moveDroneAlongPath === 'function') { "
-                           "window.moveDroneAlongPath(%1, %2); }").arg(coordsJson).arg(m_currentPathIndex);
-    m_webView->page()->runJavaScript(script);
+    syncMissionClock();
+}
+
+void MapFunctions::stopDroneAnimation(const QString& droneName)
+{
+    m_animationEngine->stopDrone(droneName);
     
-    // Increment the path index for the next update
-    m_currentPathIndex++;
+    QString script = QString("if (window.clearDroneTrack) { window.clearDroneTrack(%1); }")
+                         .arg(CoordinateCodec::scriptStringLiteral(droneName));
+    m_js->call(script);
+}
+
+void MapFunctions::stopAllDroneAnimations()
+{
+    const QStringList droneNames = m_animationEngine->activeDrones();
+    m_animationEngine->stopAll();
     
-    // If we've reached the end of the path, stop the animation
-    if (m_currentPathIndex >= m_currentPath.size()) {
-        m_animationTimer->stop();
-        m_isAnimating = false;
-        emit droneAnimationCompleted();
+    for (const QString& droneName : droneNames) {
+        QString script = QString("if (window.clearDroneTrack) { window.clearDroneTrack(%1); }")
+                             .arg(CoordinateCodec::scriptStringLiteral(droneName));
+        m_js->call(script);
     }
 }
 
+void MapFunctions::syncMissionClock()
+{
+    QString script = QString("if (window.syncMissionClock) { window.syncMissionClock(%1); }")
+                         .arg(m_animationEngine->missionTime());
+    m_js->call("syncMissionClock", script);
+}
+
+void MapFunctions::pushDroneKeyframes(const QJsonArray& keyframes)
+{
+    // One call per telemetry tick for the whole fleet
+    QString keyframesJson = QJsonDocument(keyframes).toJson(QJsonDocument::Compact);
+    QString script = QString("if (window.pushDroneKeyframes) { window.pushDroneKeyframes(%1); }").arg(keyframesJson);
+    m_js->call(script);
+}
+
 void MapFunctions::confirmDroneTask(const QString& missionType, const QString& vehicle, const QString& prompt)
 {
     // Create a confirmation dialog
@@ -244,8 +437,10 @@ void MapFunctions::confirmDroneTask(const QString& missionType, const QString& v
     int ret = msgBox.exec();
     
     if (ret == QMessageBox::Yes) {
-        // Set the active drone
-        setActiveDrone(vehicle);
+        // Set the active drone, a fleet task ("Atlas, Bolt, ...") keeps the current one
+        if (!vehicle.contains(',')) {
+            setActiveDrone(vehicle);
+        }
         
         // Load the drone paths from file to ensure we have the latest data
         checkForFileChanges();
@@ -293,6 +488,9 @@ void MapFunctions::deleteGeometricShape(const QString& shapeName)
 
 void MapFunctions::clearDronePathsOnExit()
 {
+    // Drop the in-memory paths together with their snapshot and log
+    FleetPathStore::instance().clear();
+    
     // Get current path
     QString geojsonDir = QDir::currentPath() + "/drone_geojson";
     
@@ -0,0 +1,162 @@
+#include "../../include/map/maplod.h"
+#include "../../include/map/planargeometry.h"
+#include <QtMath>
+#include <QPair>
+
+namespace {
+const double METERS_PER_PIXEL_AT_ZOOM_0 = 156543.03392;
+// Vertices closer than this to the simplified line are not visible
+const double TOLERANCE_PIXELS = 1.0;
+// Drone markers closer than this on screen are merged
+const double CLUSTER_CELL_PIXELS = 60.0;
+}
+
+const int MapLevelOfDetail::FULL_DETAIL_BAND;
+const int MapLevelOfDetail::CLUSTER_MAX_BAND;
+
+MapLevelOfDetail::MapLevelOfDetail()
+{
+}
+
+QJsonObject MapLevelOfDetail::pathForBand(const QString& id, const QJsonObject& feature, int band)
+{
+    if (band >= FULL_DETAIL_BAND) {
+        return feature;
+    }
+
+    QJsonObject geometry = feature.value("geometry").toObject();
+    const QString type = geometry.value("type").toString();
+    if (type != "LineString" && type != "MultiLineString") {
+        return feature;
+    }
+
+    QHash<int, QJsonObject>& bands = m_geometryCache[id];
+    auto cached = bands.constFind(band);
+    if (cached == bands.constEnd()) {
+        QJsonArray coordinates = geometry.value("coordinates").toArray();
+        QJsonObject simplified;
+        simplified["type"] = type;
+
+        if (type == "LineString") {
+            double latitude = coordinates.isEmpty() ? 0.0 : coordinates[0].toArray()[1].toDouble();
+            simplified["coordinates"] = simplifyLine(coordinates, toleranceForBand(band, latitude));
+        } else {
+            QJsonArray lines;
+            for (const QJsonValue& line : coordinates) {
+                QJsonArray lineCoordinates = line.toArray();
+                double latitude = lineCoordinates.isEmpty() ? 0.0 : lineCoordinates[0].toArray()[1].toDouble();
+                lines.append(simplifyLine(lineCoordinates, toleranceForBand(band, latitude)));
+            }
+            simplified["coordinates"] = lines;
+        }
+
+        cached = bands.insert(band, simplified);
+    }
+
+    QJsonObject decimated = feature;
+    decimated["geometry"] = cached.value();
+    return decimated;
+}
+
+QVector<MapLevelOfDetail::Cluster> MapLevelOfDetail::clusterPositions(const QVector<QVector3D>& positions, int band)
+{
+    QVector<Cluster> clusters;
+    if (band >= CLUSTER_MAX_BAND) {
+        clusters.reserve(positions.size());
+        for (const QVector3D& pos : positions) {
+            Cluster single;
+            single.lng = pos.x();
+            single.lat = pos.y();
+            single.alt = pos.z();
+            single.count = 1;
+            clusters.append(single);
+        }
+        return clusters;
+    }
+
+    // Bucket positions into screen-space grid cells at this zoom
+    const double worldSize = 256.0 * std::pow(2.0, qMax(0, band));
+    QHash<QPair<int, int>, int> cellIndex;
+    for (const QVector3D& pos : positions) {
+        double latRad = qDegreesToRadians(qBound(-85.0511, double(pos.y()), 85.0511));
+        double x = (pos.x() + 180.0) / 360.0 * worldSize;
+        double y = (1.0 - std::log(std::tan(latRad) + 1.0 / std::cos(latRad)) / M_PI) / 2.0 * worldSize;
+        QPair<int, int> cell(int(x / CLUSTER_CELL_PIXELS), int(y / CLUSTER_CELL_PIXELS));
+
+        auto it = cellIndex.constFind(cell);
+        if (it == cellIndex.constEnd()) {
+            it = cellIndex.insert(cell, clusters.size());
+            clusters.append(Cluster());
+        }
+
+        // Running sums, turned into centroids below
+        Cluster& cluster = clusters[it.value()];
+        cluster.lng += pos.x();
+        cluster.lat += pos.y();
+        cluster.alt += pos.z();
+        cluster.count++;
+    }
+
+    for (Cluster& cluster : clusters) {
+        cluster.lng /= cluster.count;
+        cluster.lat /= cluster.count;
+        cluster.alt /= cluster.count;
+    }
+    return clusters;
+}
+
+QJsonArray MapLevelOfDetail::simplifyLine(const QJsonArray& coordinates, double toleranceMeters)
+{
+    const int count = coordinates.size();
+    if (count < 3) {
+        return coordinates;
+    }
+
+    // Work in local meters around the first vertex
+    const LocalProjection projection(coordinates[0].toArray().at(0).toDouble(),
+                                     coordinates[0].toArray().at(1).toDouble());
+    const QPolygonF points = projection.lineToMeters(coordinates);
+
+    // Iterative Douglas-Peucker, long paths would overflow a recursive one
+    QVector<bool> keep(count, false);
+    keep[0] = true;
+    keep[count - 1] = true;
+
+    QVector<QPair<int, int>> stack;
+    stack.append(qMakePair(0, count - 1));
+    while (!stack.isEmpty()) {
+        const QPair<int, int> range = stack.takeLast();
+        const int first = range.first;
+        const int last = range.second;
+
+        double maxDistance = -1.0;
+        int farthest = -1;
+        for (int i = first + 1; i < last; ++i) {
+            const double distance = PlanarGeometry::pointSegmentDistance(points[i], points[first], points[last]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
+        }
+
+        if (farthest > 0 && maxDistance > toleranceMeters) {
+            keep[farthest] = true;
+            stack.append(qMakePair(first, farthest));
+            stack.append(qMakePair(farthest, last));
+        }
+    }
+
+    QJsonArray simplified;
+    for (int i = 0; i < count; ++i) {
+        if (keep[i]) {
+            simplified.append(coordinates[i]);
+        }
+    }
+    return simplified;
+}
+
+double MapLevelOfDetail::toleranceForBand(int band, double latitude)
+{
+    double metersPerPixel = METERS_PER_PIXEL_AT_ZOOM_0 * std::cos(qDegreesToRadians(latitude)) / std::pow(2.0, qMax(0, band));
+    return metersPerPixel * TOLERANCE_PIXELS;
+}
@@ -0,0 +1,235 @@
+#include "../../include/map/mbtilesschemehandler.h"
+#include <QWebEngineUrlScheme>
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QFile>
+#include <QDir>
+#include <QUrl>
+#include <QSqlError>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+#include <zlib.h>
+
+const QByteArray MbtilesSchemeHandler::SCHEME = QByteArrayLiteral("mbtiles");
+
+namespace {
+// Deepest zoom a tile address may have, 2^z must fit an int
+const int MAX_TILE_ZOOM = 30;
+}
+
+void MbtilesSchemeHandler::registerScheme()
+{
+    QWebEngineUrlScheme scheme(SCHEME);
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    scheme.setFlags(QWebEngineUrlScheme::SecureScheme |
+                    QWebEngineUrlScheme::CorsEnabled |
+                    QWebEngineUrlScheme::ContentSecurityPolicyIgnored);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+QString MbtilesSchemeHandler::defaultStorePath()
+{
+    return QDir::currentPath() + "/tiles/offline.mbtiles";
+}
+
+MbtilesSchemeHandler::MbtilesSchemeHandler(const QString& mbtilesPath, QObject* parent)
+    : QWebEngineUrlSchemeHandler(parent)
+    , m_connectionName(QString("mbtiles_%1").arg(quintptr(this)))
+{
+    if (!QFile::exists(mbtilesPath)) {
+        qDebug() << "No offline tile store at:" << mbtilesPath;
+        return;
+    }
+
+    // Own read-only connection, the default one belongs to DatabaseManager
+    m_database = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    m_database.setDatabaseName(mbtilesPath);
+    m_database.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!m_database.open()) {
+        qWarning() << "Error opening offline tile store:" << m_database.lastError().text();
+        return;
+    }
+
+    m_tileQuery = QSqlQuery(m_database);
+    m_tileQuery.prepare("SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?");
+    qDebug() << "Serving offline tiles from:" << mbtilesPath;
+}
+
+MbtilesSchemeHandler::~MbtilesSchemeHandler()
+{
+    m_tileQuery = QSqlQuery();
+    m_database.close();
+    m_database = QSqlDatabase();
+    if (QSqlDatabase::contains(m_connectionName)) {
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+}
+
+void MbtilesSchemeHandler::requestStarted(QWebEngineUrlRequestJob* job)
+{
+    const QUrl url = job->requestUrl();
+    const QString host = url.host();
+    const QString path = url.path();
+
+    QByteArray data;
+    QByteArray contentType;
+
+    if (host == "style") {
+        data = styleJson();
+        contentType = "application/json";
+    } else if (host == "tiles" && path == "/tiles.json") {
+        data = tileJson();
+        contentType = "application/json";
+    } else if (host == "tiles") {
+        // /{z}/{x}/{y}.pbf
+        const QStringList parts = path.mid(1).split('/');
+        bool okZ = false, okX = false, okY = false;
+        int z = parts.value(0).toInt(&okZ);
+        int x = parts.value(1).toInt(&okX);
+        int y = parts.value(2).section('.', 0, 0).toInt(&okY);
+        if (parts.size() != 3 || !okZ || !okX || !okY) {
+            job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+            return;
+        }
+
+        // The address comes from the page, keep it inside the tile grid
+        const int tiles = (z >= 0 && z <= MAX_TILE_ZOOM) ? (1 << z) : 0;
+        if (tiles == 0 || x < 0 || x >= tiles || y < 0 || y >= tiles) {
+            job->fail(QWebEngineUrlRequestJob::UrlInvalid);
+            return;
+        }
+
+        // Missing tiles are answered with an empty tile rather than an error
+        data = readTile(z, x, y);
+        contentType = "application/x-protobuf";
+    } else {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    if (data.isNull() && contentType == "application/json") {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    QBuffer* buffer = new QBuffer(job);
+    buffer->setData(data);
+    job->reply(contentType, buffer);
+}
+
+QByteArray MbtilesSchemeHandler::readTile(int z, int x, int y)
+{
+    if (!isOpen()) {
+        return QByteArray("");
+    }
+
+    // MBTiles rows use the TMS scheme, y grows northwards
+    int tmsY = (1 << z) - 1 - y;
+    m_tileQuery.bindValue(0, z);
+    m_tileQuery.bindValue(1, x);
+    m_tileQuery.bindValue(2, tmsY);
+    if (!m_tileQuery.exec()) {
+        qWarning() << "Error reading offline tile:" << m_tileQuery.lastError().text();
+        return QByteArray("");
+    }
+
+    QByteArray tile = m_tileQuery.next() ? m_tileQuery.value(0).toByteArray() : QByteArray("");
+    m_tileQuery.finish();
+
+    // Vector tiles are usually stored gzipped, the page cannot inflate them
+    if (tile.size() > 2 && uchar(tile[0]) == 0x1f && uchar(tile[1]) == 0x8b) {
+        return inflateGzip(tile);
+    }
+    return tile;
+}
+
+QByteArray MbtilesSchemeHandler::styleJson() const
+{
+    const QStringList candidates = {
+        QCoreApplication::applicationDirPath() + "/resources/styles/offline_dark.json",
+        QDir::currentPath() + "/resources/styles/offline_dark.json"
+    };
+
+    for (const QString& candidate : candidates) {
+        QFile file(candidate);
+        if (file.open(QIODevice::ReadOnly)) {
+            return file.readAll();
+        }
+    }
+
+    qWarning() << "Offline map style not found";
+    return QByteArray();
+}
+
+QByteArray MbtilesSchemeHandler::tileJson()
+{
+    if (!m_tileJson.isEmpty() || !isOpen()) {
+        return m_tileJson;
+    }
+
+    QJsonObject tileJsonObj;
+    tileJsonObj["tilejson"] = "2.2.0";
+    tileJsonObj["scheme"] = "xyz";
+    tileJsonObj["tiles"] = QJsonArray{QString("%1://tiles/{z}/{x}/{y}.pbf").arg(QString::fromLatin1(SCHEME))};
+    tileJsonObj["minzoom"] = 0;
+    tileJsonObj["maxzoom"] = 14;
+
+    // Zoom range and bounds come from the metadata table
+    QSqlQuery query(m_database);
+    if (query.exec("SELECT name, value FROM metadata")) {
+        while (query.next()) {
+            const QString name = query.value(0).toString();
+            const QString value = query.value(1).toString();
+            if (name == "minzoom" || name == "maxzoom") {
+                tileJsonObj[name] = value.toInt();
+            } else if (name == "bounds") {
+                QJsonArray bounds;
+                for (const QString& part : value.split(',')) {
+                    bounds.append(part.trimmed().toDouble());
+                }
+                if (bounds.size() == 4) {
+                    tileJsonObj["bounds"] = bounds;
+                }
+            } else if (name == "name" || name == "attribution") {
+                tileJsonObj[name] = value;
+            }
+        }
+    } else {
+        qWarning() << "Error reading offline tile metadata:" << query.lastError().text();
+    }
+
+    m_tileJson = QJsonDocument(tileJsonObj).toJson(QJsonDocument::Compact);
+    return m_tileJson;
+}
+
+QByteArray MbtilesSchemeHandler::inflateGzip(const QByteArray& data)
+{
+    z_stream stream = {};
+    // 16 + MAX_WBITS accepts the gzip header
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        return QByteArray("");
+    }
+
+    QByteArray output;
+    char chunk[16384];
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+    stream.avail_in = uInt(data.size());
+
+    int result = Z_OK;
+    while (result == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef*>(chunk);
+        stream.avail_out = sizeof(chunk);
+        result = inflate(&stream, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END) {
+            qWarning() << "Error inflating offline tile:" << result;
+            inflateEnd(&stream);
+            return QByteArray("");
+        }
+        output.append(chunk, int(sizeof(chunk) - stream.avail_out));
+    }
+
+    inflateEnd(&stream);
+    return output;
+}
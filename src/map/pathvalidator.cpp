@@ -0,0 +1,289 @@
+#include "../../include/map/pathvalidator.h"
+#include <QtConcurrent>
+#include <QStringList>
+#include <limits>
+
+const double PathValidator::DEFAULT_CLEARANCE_METERS = 20.0;
+
+namespace {
+const char* violationTypeName(PathViolation::Type type)
+{
+    switch (type) {
+    case PathViolation::Intersects: return "intersects";
+    case PathViolation::Inside: return "inside";
+    case PathViolation::Unsupported: return "unsupported";
+    case PathViolation::Clearance: break;
+    }
+    return "clearance";
+}
+}
+
+QJsonObject PathViolation::toJson() const
+{
+    QJsonObject json;
+    json["segment"] = segment;
+    json["type"] = violationTypeName(type);
+    json["shapeId"] = shapeId;
+    json["shapeName"] = shapeName;
+    json["distance"] = distanceMeters;
+    return json;
+}
+
+QJsonArray PathValidationResult::violationsJson() const
+{
+    QJsonArray json;
+    for (const PathViolation& violation : violations) {
+        json.append(violation.toJson());
+    }
+    return json;
+}
+
+QString PathValidationResult::summary() const
+{
+    QStringList lines;
+    for (const PathViolation& violation : violations) {
+        QString shape = violation.shapeName.isEmpty() ? violation.shapeId : violation.shapeName;
+        switch (violation.type) {
+        case PathViolation::Unsupported:
+            lines << QString("the path is not a LineString");
+            break;
+        case PathViolation::Intersects:
+            lines << QString("segment %1 crosses %2").arg(violation.segment).arg(shape);
+            break;
+        case PathViolation::Inside:
+            lines << QString("segment %1 is inside %2").arg(violation.segment).arg(shape);
+            break;
+        case PathViolation::Clearance:
+            lines << QString("segment %1 passes %2 m from %3")
+                         .arg(violation.segment)
+                         .arg(violation.distanceMeters, 0, 'f', 1)
+                         .arg(shape);
+            break;
+        }
+    }
+    return lines.join("\n");
+}
+
+PathValidator::PathValidator()
+    : m_minimumClearance(DEFAULT_CLEARANCE_METERS)
+    , m_maximumShapeClearance(0.0)
+{
+}
+
+void PathValidator::setShapes(const QJsonObject& collection)
+{
+    m_shapes.clear();
+    m_index.clear();
+
+    const QJsonArray features = collection.value("features").toArray();
+    QVector<SpatialIndex::Entry> entries;
+    m_maximumShapeClearance = 0.0;
+    for (const QJsonValue& value : features) {
+        const QJsonObject feature = value.toObject();
+        const QJsonObject properties = feature.value("properties").toObject();
+
+        PreparedShape shape;
+        shape.id = feature.value("id").isDouble() ? QString::number(feature.value("id").toDouble())
+                                                  : feature.value("id").toString();
+        shape.name = properties.value("name").toString();
+        if (properties.value("clearance").isDouble()) {
+            shape.clearance = qMax(0.0, properties.value("clearance").toDouble());
+            m_maximumShapeClearance = qMax(m_maximumShapeClearance, shape.clearance);
+        }
+
+        // Every shape is projected around its own center
+        const QJsonObject geometry = feature.value("geometry").toObject();
+        SpatialIndex::Entry entry;
+        entry.box = BoundingBox::ofGeometry(geometry);
+        if (entry.box.isNull()) {
+            continue;
+        }
+        shape.projection = LocalProjection(entry.box.centerX(), entry.box.centerY());
+        prepareGeometry(geometry, shape);
+
+        entry.value = m_shapes.size();
+        entries.append(entry);
+        m_shapes.append(shape);
+    }
+
+    m_index.build(entries);
+}
+
+void PathValidator::setMinimumClearance(double meters)
+{
+    m_minimumClearance = qMax(0.0, meters);
+}
+
+PathValidationResult PathValidator::validate(const QString& droneName, const QJsonObject& pathFeature) const
+{
+    PathValidationResult result;
+    result.droneName = droneName;
+
+    // Anything but a line cannot be checked and is not a valid path
+    const QJsonObject geometry = pathFeature.value("geometry").toObject();
+    if (geometry.value("type").toString() != "LineString") {
+        PathViolation violation;
+        violation.type = PathViolation::Unsupported;
+        result.violations.append(violation);
+        return result;
+    }
+    if (m_index.isEmpty()) {
+        return result;
+    }
+
+    const QJsonArray path = geometry.value("coordinates").toArray();
+    const double reachMeters = qMax(m_minimumClearance, m_maximumShapeClearance);
+
+    // A single vertex path is checked as a zero length segment
+    const int segmentCount = qMax(1, path.size() - 1);
+    for (int i = 0; i < segmentCount && !path.isEmpty(); ++i) {
+        const QJsonArray from = path[i].toArray();
+        const QJsonArray to = path[qMin(i + 1, path.size() - 1)].toArray();
+
+        BoundingBox reach;
+        reach.expand(from.at(0).toDouble(), from.at(1).toDouble());
+        reach.expand(to.at(0).toDouble(), to.at(1).toDouble());
+
+        // Grown by the reach where a degree of longitude is shortest
+        const LocalProjection local(reach.centerX(), qMin(89.0, qMax(qAbs(reach.minY), qAbs(reach.maxY))));
+        reach.minX -= local.lngDegrees(reachMeters);
+        reach.maxX += local.lngDegrees(reachMeters);
+        reach.minY -= local.latDegrees(reachMeters);
+        reach.maxY += local.latDegrees(reachMeters);
+
+        for (int candidate : m_index.queryBox(reach)) {
+            const PreparedShape& shape = m_shapes[candidate];
+            PathViolation violation;
+            if (checkSegment(shape.projection.toMeters(from), shape.projection.toMeters(to), shape, violation)) {
+                violation.segment = i;
+                result.violations.append(violation);
+            }
+        }
+    }
+    return result;
+}
+
+QMap<QString, PathValidationResult> PathValidator::validateFleet(const QMap<QString, QJsonObject>& paths) const
+{
+    struct Job {
+        QString droneName;
+        QJsonObject feature;
+        PathValidationResult result;
+    };
+
+    QVector<Job> jobs;
+    jobs.reserve(paths.size());
+    for (auto it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        jobs.append({it.key(), it.value(), PathValidationResult()});
+    }
+
+    // A single path is not worth a thread hop
+    if (jobs.size() == 1) {
+        jobs[0].result = validate(jobs[0].droneName, jobs[0].feature);
+    } else if (jobs.size() > 1) {
+        QtConcurrent::blockingMap(jobs, [this](Job& job) {
+            job.result = validate(job.droneName, job.feature);
+        });
+    }
+
+    QMap<QString, PathValidationResult> results;
+    for (const Job& job : qAsConst(jobs)) {
+        results.insert(job.droneName, job.result);
+    }
+    return results;
+}
+
+void PathValidator::prepareGeometry(const QJsonObject& geometry, PreparedShape& shape) const
+{
+    const QString type = geometry.value("type").toString();
+    const QJsonArray coordinates = geometry.value("coordinates").toArray();
+    const LocalProjection& projection = shape.projection;
+
+    auto addPolygon = [&shape, &projection](const QJsonArray& ringsJson) {
+        QVector<QPolygonF> rings;
+        for (const QJsonValue& ring : ringsJson) {
+            rings.append(projection.lineToMeters(ring.toArray()));
+        }
+        if (!rings.isEmpty()) {
+            shape.polygons.append(rings);
+        }
+    };
+
+    if (type == "Polygon") {
+        addPolygon(coordinates);
+    } else if (type == "MultiPolygon") {
+        for (const QJsonValue& polygon : coordinates) {
+            addPolygon(polygon.toArray());
+        }
+    } else if (type == "LineString") {
+        shape.lines.append(projection.lineToMeters(coordinates));
+    } else if (type == "MultiLineString") {
+        for (const QJsonValue& line : coordinates) {
+            shape.lines.append(projection.lineToMeters(line.toArray()));
+        }
+    } else if (type == "Point") {
+        shape.points.append(projection.toMeters(coordinates));
+    } else if (type == "MultiPoint") {
+        for (const QJsonValue& point : coordinates) {
+            shape.points.append(projection.toMeters(point.toArray()));
+        }
+    } else if (type == "GeometryCollection") {
+        for (const QJsonValue& child : geometry.value("geometries").toArray()) {
+            prepareGeometry(child.toObject(), shape);
+        }
+    }
+}
+
+double PathValidator::clearanceOf(const PreparedShape& shape) const
+{
+    return shape.clearance >= 0.0 ? shape.clearance : m_minimumClearance;
+}
+
+bool PathValidator::checkSegment(const QPointF& a, const QPointF& b, const PreparedShape& shape, PathViolation& violation) const
+{
+    violation.shapeId = shape.id;
+    violation.shapeName = shape.name;
+
+    // Most severe finding wins: crossing, then inside, then clearance
+    double distance = std::numeric_limits<double>::max();
+    for (const QVector<QPolygonF>& rings : shape.polygons) {
+        double ringDistance = PlanarGeometry::segmentRingsDistance(a, b, rings);
+        if (ringDistance == 0.0) {
+            violation.type = PathViolation::Intersects;
+            violation.distanceMeters = 0.0;
+            return true;
+        }
+        // Without a crossing the whole segment is on one side of the boundary
+        if (PlanarGeometry::ringsContain(rings, a)) {
+            violation.type = PathViolation::Inside;
+            violation.distanceMeters = 0.0;
+            return true;
+        }
+        distance = qMin(distance, ringDistance);
+    }
+
+    for (const QPolygonF& line : shape.lines) {
+        for (int i = 1; i < line.size(); ++i) {
+            distance = qMin(distance, PlanarGeometry::segmentDistance(a, b, line[i - 1], line[i]));
+        }
+        if (line.size() == 1) {
+            distance = qMin(distance, PlanarGeometry::pointSegmentDistance(line[0], a, b));
+        }
+    }
+    if (distance == 0.0) {
+        violation.type = PathViolation::Intersects;
+        violation.distanceMeters = 0.0;
+        return true;
+    }
+
+    for (const QPointF& point : shape.points) {
+        distance = qMin(distance, PlanarGeometry::pointSegmentDistance(point, a, b));
+    }
+
+    if (distance < clearanceOf(shape)) {
+        violation.type = PathViolation::Clearance;
+        violation.distanceMeters = distance;
+        return true;
+    }
+    return false;
+}
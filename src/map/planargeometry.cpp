@@ -0,0 +1,132 @@
+#include "../../include/map/planargeometry.h"
+#include <QtMath>
+#include <limits>
+
+namespace {
+const double EARTH_RADIUS_M = 6371000.0;
+
+double cross(const QPointF& o, const QPointF& a, const QPointF& b)
+{
+    return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+bool onSegment(const QPointF& a, const QPointF& b, const QPointF& p)
+{
+    return qMin(a.x(), b.x()) <= p.x() && p.x() <= qMax(a.x(), b.x()) &&
+           qMin(a.y(), b.y()) <= p.y() && p.y() <= qMax(a.y(), b.y());
+}
+}
+
+LocalProjection::LocalProjection(double originLng, double originLat)
+    : m_originLng(originLng)
+    , m_originLat(originLat)
+{
+    m_metersPerDegreeLat = qDegreesToRadians(1.0) * EARTH_RADIUS_M;
+    m_metersPerDegreeLng = m_metersPerDegreeLat * std::cos(qDegreesToRadians(originLat));
+}
+
+QPointF LocalProjection::toMeters(double lng, double lat) const
+{
+    return QPointF((lng - m_originLng) * m_metersPerDegreeLng, (lat - m_originLat) * m_metersPerDegreeLat);
+}
+
+QPointF LocalProjection::toMeters(const QJsonArray& position) const
+{
+    return toMeters(position.at(0).toDouble(), position.at(1).toDouble());
+}
+
+void LocalProjection::toLngLat(const QPointF& meters, double& lng, double& lat) const
+{
+    lng = m_originLng + meters.x() / m_metersPerDegreeLng;
+    lat = m_originLat + meters.y() / m_metersPerDegreeLat;
+}
+
+QPolygonF LocalProjection::lineToMeters(const QJsonArray& positions) const
+{
+    QPolygonF line;
+    line.reserve(positions.size());
+    for (const QJsonValue& position : positions) {
+        line.append(toMeters(position.toArray()));
+    }
+    return line;
+}
+
+QPolygonF PlanarGeometry::positionsToPolygon(const QJsonArray& positions)
+{
+    QPolygonF points;
+    points.reserve(positions.size());
+    for (const QJsonValue& position : positions) {
+        const QJsonArray values = position.toArray();
+        points.append(QPointF(values.at(0).toDouble(), values.at(1).toDouble()));
+    }
+    return points;
+}
+
+double PlanarGeometry::pointSegmentDistance(const QPointF& p, const QPointF& a, const QPointF& b)
+{
+    const double dx = b.x() - a.x();
+    const double dy = b.y() - a.y();
+    const double lengthSquared = dx * dx + dy * dy;
+    double t = 0.0;
+    if (lengthSquared > 0.0) {
+        t = qBound(0.0, ((p.x() - a.x()) * dx + (p.y() - a.y()) * dy) / lengthSquared, 1.0);
+    }
+    const double ex = p.x() - (a.x() + t * dx);
+    const double ey = p.y() - (a.y() + t * dy);
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+bool PlanarGeometry::segmentsIntersect(const QPointF& a, const QPointF& b, const QPointF& c, const QPointF& d)
+{
+    const double d1 = cross(c, d, a);
+    const double d2 = cross(c, d, b);
+    const double d3 = cross(a, b, c);
+    const double d4 = cross(a, b, d);
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+        return true;
+    }
+
+    // Touching and collinear cases
+    return (d1 == 0 && onSegment(c, d, a)) || (d2 == 0 && onSegment(c, d, b)) ||
+           (d3 == 0 && onSegment(a, b, c)) || (d4 == 0 && onSegment(a, b, d));
+}
+
+double PlanarGeometry::segmentDistance(const QPointF& a, const QPointF& b, const QPointF& c, const QPointF& d)
+{
+    if (segmentsIntersect(a, b, c, d)) {
+        return 0.0;
+    }
+    return qMin(qMin(pointSegmentDistance(a, c, d), pointSegmentDistance(b, c, d)),
+                qMin(pointSegmentDistance(c, a, b), pointSegmentDistance(d, a, b)));
+}
+
+bool PlanarGeometry::ringsContain(const QVector<QPolygonF>& rings, const QPointF& p)
+{
+    bool inside = false;
+    for (const QPolygonF& ring : rings) {
+        const int count = ring.size();
+        for (int i = 0, j = count - 1; i < count; j = i++) {
+            const QPointF& a = ring[i];
+            const QPointF& b = ring[j];
+            if ((a.y() > p.y()) != (b.y() > p.y()) &&
+                p.x() < (b.x() - a.x()) * (p.y() - a.y()) / (b.y() - a.y()) + a.x()) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+double PlanarGeometry::segmentRingsDistance(const QPointF& a, const QPointF& b, const QVector<QPolygonF>& rings)
+{
+    double distance = std::numeric_limits<double>::max();
+    for (const QPolygonF& ring : rings) {
+        for (int i = 1; i < ring.size(); ++i) {
+            distance = qMin(distance, segmentDistance(a, b, ring[i - 1], ring[i]));
+            if (distance == 0.0) {
+                return 0.0;
+            }
+        }
+    }
+    return distance;
+}
@@ -0,0 +1,314 @@
+#include "../../include/map/polygonclipper.h"
+#include "../../include/map/spatialindex.h"
+#include <QPainterPathStroker>
+#include <QJsonArray>
+#include <QMap>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+// Rings smaller than this (square meters) are clipping slivers
+const double MIN_RING_AREA = 0.01;
+
+double signedArea(const QPolygonF& ring)
+{
+    double area = 0.0;
+    for (int i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        area += (ring[j].x() * ring[i].y()) - (ring[i].x() * ring[j].y());
+    }
+    return area / 2.0;
+}
+
+QJsonArray ringToJson(QPolygonF ring, bool counterClockwise, const LocalProjection& projection)
+{
+    if ((signedArea(ring) > 0.0) != counterClockwise) {
+        std::reverse(ring.begin(), ring.end());
+    }
+    if (ring.first() != ring.last()) {
+        ring.append(ring.first());
+    }
+
+    QJsonArray positions;
+    for (const QPointF& point : ring) {
+        double lng;
+        double lat;
+        projection.toLngLat(point, lng, lat);
+        positions.append(QJsonArray{lng, lat});
+    }
+    return positions;
+}
+
+void addRings(QPainterPath& path, const QJsonArray& rings, const LocalProjection& projection)
+{
+    for (const QJsonValue& ring : rings) {
+        QPolygonF points = projection.lineToMeters(ring.toArray());
+        if (points.size() >= 3) {
+            path.addPolygon(points);
+            path.closeSubpath();
+        }
+    }
+}
+
+// Outline of every polygon ring and line, for the stroker
+void addOutlines(QPainterPath& path, const QJsonObject& geometry, const LocalProjection& projection)
+{
+    const QString type = geometry.value("type").toString();
+    const QJsonArray coordinates = geometry.value("coordinates").toArray();
+    if (type == "LineString") {
+        path.addPolygon(projection.lineToMeters(coordinates));
+    } else if (type == "MultiLineString" || type == "Polygon") {
+        for (const QJsonValue& line : coordinates) {
+            path.addPolygon(projection.lineToMeters(line.toArray()));
+        }
+    } else if (type == "MultiPolygon") {
+        for (const QJsonValue& polygon : coordinates) {
+            for (const QJsonValue& ring : polygon.toArray()) {
+                path.addPolygon(projection.lineToMeters(ring.toArray()));
+            }
+        }
+    } else if (type == "GeometryCollection") {
+        for (const QJsonValue& child : geometry.value("geometries").toArray()) {
+            addOutlines(path, child.toObject(), projection);
+        }
+    }
+}
+
+void addPoints(QPainterPath& path, const QJsonObject& geometry, double radius, const LocalProjection& projection)
+{
+    const QString type = geometry.value("type").toString();
+    if (type == "Point") {
+        path.addEllipse(projection.toMeters(geometry.value("coordinates").toArray()), radius, radius);
+    } else if (type == "MultiPoint") {
+        for (const QJsonValue& position : geometry.value("coordinates").toArray()) {
+            path.addEllipse(projection.toMeters(position.toArray()), radius, radius);
+        }
+    } else if (type == "GeometryCollection") {
+        for (const QJsonValue& child : geometry.value("geometries").toArray()) {
+            addPoints(path, child.toObject(), radius, projection);
+        }
+    }
+}
+
+int findRoot(QVector<int>& parents, int index)
+{
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+}
+
+QJsonObject PolygonClipper::unite(const QVector<QJsonObject>& geometries)
+{
+    const LocalProjection projection = projectionFor(geometries);
+    QPainterPath result;
+    for (const QJsonObject& geometry : geometries) {
+        result = result.united(toPath(geometry, projection));
+    }
+    return toGeometry(result, projection);
+}
+
+QJsonObject PolygonClipper::intersect(const QJsonObject& a, const QJsonObject& b)
+{
+    const LocalProjection projection = projectionFor({a, b});
+    return toGeometry(toPath(a, projection).intersected(toPath(b, projection)), projection);
+}
+
+QJsonObject PolygonClipper::subtract(const QJsonObject& geometry, const QVector<QJsonObject>& cutters)
+{
+    QVector<QJsonObject> all = cutters;
+    all.prepend(geometry);
+    const LocalProjection projection = projectionFor(all);
+
+    QPainterPath cut;
+    for (const QJsonObject& cutter : cutters) {
+        cut.addPath(toPath(cutter, projection));
+    }
+    // Overlapping cutters must not cancel out under the even-odd rule
+    cut = cut.simplified();
+    return toGeometry(toPath(geometry, projection).subtracted(cut), projection);
+}
+
+QJsonObject PolygonClipper::buffer(const QJsonObject& geometry, double distanceMeters)
+{
+    const LocalProjection projection = projectionFor({geometry});
+    const QPainterPath area = toPath(geometry, projection);
+    if (qFuzzyIsNull(distanceMeters)) {
+        return toGeometry(area, projection);
+    }
+
+    QPainterPath outlines;
+    addOutlines(outlines, geometry, projection);
+
+    QPainterPathStroker stroker;
+    stroker.setWidth(2.0 * qAbs(distanceMeters));
+    stroker.setJoinStyle(Qt::RoundJoin);
+    stroker.setCapStyle(Qt::RoundCap);
+    const QPainterPath band = stroker.createStroke(outlines).simplified();
+
+    if (distanceMeters < 0.0) {
+        return toGeometry(area.subtracted(band), projection);
+    }
+
+    QPainterPath points;
+    addPoints(points, geometry, distanceMeters, projection);
+    return toGeometry(area.united(band).united(points.simplified()), projection);
+}
+
+QVector<PolygonClipper::MergedGroup> PolygonClipper::mergeOverlapping(const QVector<QJsonObject>& geometries)
+{
+    const LocalProjection projection = projectionFor(geometries);
+    QVector<QPainterPath> paths;
+    QVector<SpatialIndex::Entry> entries;
+    paths.reserve(geometries.size());
+    for (int i = 0; i < geometries.size(); ++i) {
+        paths.append(toPath(geometries[i], projection));
+
+        SpatialIndex::Entry entry;
+        entry.box = BoundingBox::ofGeometry(geometries[i]);
+        entry.value = i;
+        if (!entry.box.isNull() && !paths[i].isEmpty()) {
+            entries.append(entry);
+        }
+    }
+
+    SpatialIndex index;
+    index.build(entries);
+
+    // Union-find over pairs whose boxes and then areas overlap
+    QVector<int> parents(geometries.size());
+    for (int i = 0; i < parents.size(); ++i) {
+        parents[i] = i;
+    }
+    for (const SpatialIndex::Entry& entry : entries) {
+        const int i = entry.value;
+        for (int j : index.queryBox(entry.box)) {
+            if (j <= i || findRoot(parents, i) == findRoot(parents, j)) {
+                continue;
+            }
+            if (paths[i].intersects(paths[j])) {
+                parents[findRoot(parents, j)] = findRoot(parents, i);
+            }
+        }
+    }
+
+    QMap<int, QVector<int>> members;
+    for (const SpatialIndex::Entry& entry : entries) {
+        members[findRoot(parents, entry.value)].append(entry.value);
+    }
+
+    QVector<MergedGroup> groups;
+    for (const QVector<int>& group : members) {
+        if (group.size() < 2) {
+            continue;
+        }
+
+        QPainterPath merged;
+        for (int i : group) {
+            merged = merged.united(paths[i]);
+        }
+
+        MergedGroup result;
+        result.members = group;
+        result.geometry = toGeometry(merged, projection);
+        groups.append(result);
+    }
+    return groups;
+}
+
+LocalProjection PolygonClipper::projectionFor(const QVector<QJsonObject>& geometries)
+{
+    BoundingBox bounds;
+    for (const QJsonObject& geometry : geometries) {
+        const BoundingBox box = BoundingBox::ofGeometry(geometry);
+        if (!box.isNull()) {
+            bounds.expand(box);
+        }
+    }
+    return bounds.isNull() ? LocalProjection() : LocalProjection(bounds.centerX(), bounds.centerY());
+}
+
+QPainterPath PolygonClipper::toPath(const QJsonObject& geometry, const LocalProjection& projection)
+{
+    QPainterPath path;
+    path.setFillRule(Qt::OddEvenFill);
+
+    const QString type = geometry.value("type").toString();
+    const QJsonArray coordinates = geometry.value("coordinates").toArray();
+    if (type == "Polygon") {
+        addRings(path, coordinates, projection);
+    } else if (type == "MultiPolygon") {
+        // Polygons are united so overlapping parts do not cancel out
+        for (const QJsonValue& polygon : coordinates) {
+            QPainterPath part;
+            part.setFillRule(Qt::OddEvenFill);
+            addRings(part, polygon.toArray(), projection);
+            path = path.united(part);
+        }
+    } else if (type == "GeometryCollection") {
+        for (const QJsonValue& child : geometry.value("geometries").toArray()) {
+            path = path.united(toPath(child.toObject(), projection));
+        }
+    }
+    return path;
+}
+
+QJsonObject PolygonClipper::toGeometry(const QPainterPath& path, const LocalProjection& projection)
+{
+    QVector<QPolygonF> rings;
+    QVector<double> areas;
+    for (const QPolygonF& ring : path.toSubpathPolygons()) {
+        const double area = qAbs(signedArea(ring));
+        if (ring.size() >= 3 && area > MIN_RING_AREA) {
+            rings.append(ring);
+            areas.append(area);
+        }
+    }
+
+    // Rings inside an even number of others are outer rings, the rest are
+    // holes of the smallest ring around them
+    QVector<int> depths(rings.size(), 0);
+    QVector<int> parents(rings.size(), -1);
+    for (int i = 0; i < rings.size(); ++i) {
+        for (int j = 0; j < rings.size(); ++j) {
+            if (i == j || areas[j] <= areas[i] || !rings[j].containsPoint(rings[i].first(), Qt::OddEvenFill)) {
+                continue;
+            }
+            depths[i]++;
+            if (parents[i] < 0 || areas[j] < areas[parents[i]]) {
+                parents[i] = j;
+            }
+        }
+    }
+
+    QMap<int, QJsonArray> polygons;
+    for (int i = 0; i < rings.size(); ++i) {
+        if (depths[i] % 2 == 0) {
+            polygons[i].prepend(ringToJson(rings[i], true, projection));
+        }
+    }
+    for (int i = 0; i < rings.size(); ++i) {
+        if (depths[i] % 2 == 1 && polygons.contains(parents[i])) {
+            polygons[parents[i]].append(ringToJson(rings[i], false, projection));
+        }
+    }
+
+    if (polygons.isEmpty()) {
+        return QJsonObject();
+    }
+
+    QJsonObject geometry;
+    if (polygons.size() == 1) {
+        geometry["type"] = "Polygon";
+        geometry["coordinates"] = polygons.first();
+    } else {
+        QJsonArray multi;
+        for (const QJsonArray& polygon : polygons) {
+            multi.append(polygon);
+        }
+        geometry["type"] = "MultiPolygon";
+        geometry["coordinates"] = multi;
+    }
+    return geometry;
+}
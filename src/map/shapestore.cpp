@@ -0,0 +1,643 @@
+#include "../../include/map/shapestore.h"
+#include "../../include/drone/UpdateBus.h"
+#include "../../include/map/binarygeometry.h"
+#include "../../include/map/planargeometry.h"
+#include "../../include/map/polygonclipper.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QMap>
+#include <QDebug>
+#include <limits>
+
+namespace {
+bool readGeoJson(const QString& path, QJsonObject& collection)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open geometric shapes file:" << file.errorString();
+        return false;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        qWarning() << "Invalid geometric shapes file:" << path;
+        return false;
+    }
+    collection = doc.object();
+    return true;
+}
+
+// Compact once the log holds as many records as there are shapes
+const int MIN_LOG_RECORDS = 64;
+// Rebuild the R-tree once an eighth of the shapes changed since it was built
+const int MIN_INDEX_CHANGES = 64;
+const int INDEX_CHANGES_DIVISOR = 8;
+const char* GENERATED_ID_PREFIX = "shape-";
+
+// Even-odd test in degrees over every ring, so holes are excluded
+bool ringsContain(const QJsonArray& rings, double x, double y)
+{
+    QVector<QPolygonF> polygons;
+    polygons.reserve(rings.size());
+    for (const QJsonValue& ring : rings) {
+        polygons.append(PlanarGeometry::positionsToPolygon(ring.toArray()));
+    }
+    return PlanarGeometry::ringsContain(polygons, QPointF(x, y));
+}
+
+bool geometryContains(const QJsonObject& geometry, double x, double y)
+{
+    const QString type = geometry.value("type").toString();
+    const QJsonArray coordinates = geometry.value("coordinates").toArray();
+    if (type == "Polygon") {
+        return ringsContain(coordinates, x, y);
+    }
+    if (type == "MultiPolygon") {
+        for (const QJsonValue& polygon : coordinates) {
+            if (ringsContain(polygon.toArray(), x, y)) {
+                return true;
+            }
+        }
+    }
+    if (type == "GeometryCollection") {
+        for (const QJsonValue& child : geometry.value("geometries").toArray()) {
+            if (geometryContains(child.toObject(), x, y)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+}
+
+ShapeStore& ShapeStore::instance()
+{
+    static ShapeStore instance;
+    return instance;
+}
+
+ShapeStore::ShapeStore(QObject* parent)
+    : QObject(parent)
+    , m_directory(QDir::currentPath() + "/drone_geojson")
+    , m_revision(0)
+    , m_nextId(1)
+    , m_logRecords(0)
+    , m_cachedRevision(std::numeric_limits<quint64>::max())
+    , m_mergedRevision(std::numeric_limits<quint64>::max())
+    , m_indexStale(true)
+{
+    // Ensure directory exists
+    QDir dir(m_directory);
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    loadSnapshot();
+}
+
+ShapeStore::~ShapeStore()
+{
+}
+
+QString ShapeStore::addShape(const QJsonObject& feature)
+{
+    QString id = insertShape(feature);
+    QHash<QString, QJsonObject> upserted;
+    upserted.insert(id, m_shapes.value(id).feature);
+    changed(upserted, QStringList());
+    return id;
+}
+
+QStringList ShapeStore::addShapes(const QJsonArray& features)
+{
+    QStringList ids;
+    QHash<QString, QJsonObject> upserted;
+    for (const QJsonValue& value : features) {
+        QString id = insertShape(value.toObject());
+        ids.append(id);
+        upserted.insert(id, m_shapes.value(id).feature);
+    }
+    if (!ids.isEmpty()) {
+        changed(upserted, QStringList());
+    }
+    return ids;
+}
+
+QStringList ShapeStore::importShapes(const QVector<QJsonObject>& features, const QVector<BoundingBox>& boxes,
+                                     const QVector<QJsonObject>& rendered)
+{
+    QStringList ids;
+    ids.reserve(features.size());
+    QHash<QString, QJsonObject> upserted;
+    upserted.reserve(features.size());
+    for (int i = 0; i < features.size(); ++i) {
+        QString id = insertShape(features[i], i < boxes.size() ? &boxes[i] : nullptr);
+        ids.append(id);
+
+        QJsonObject drawn = i < rendered.size() ? rendered[i] : m_shapes.value(id).feature;
+        drawn["id"] = id;
+        upserted.insert(id, drawn);
+    }
+    if (ids.isEmpty()) {
+        return ids;
+    }
+
+    {
+        QMutexLocker locker(&m_indexMutex);
+        m_revision++;
+    }
+    UpdateBus::instance().publishShapeChanges(upserted, QStringList());
+
+    // Thousands of log records would be compacted right away, write the
+    // snapshot once instead
+    compact();
+    return ids;
+}
+
+bool ShapeStore::removeShape(const QString& id)
+{
+    {
+        QMutexLocker locker(&m_indexMutex);
+        if (!m_shapes.remove(id)) {
+            return false;
+        }
+        m_changedIds.insert(id);
+    }
+    changed(QHash<QString, QJsonObject>(), QStringList{id});
+    return true;
+}
+
+int ShapeStore::removeShapesNamed(const QString& name)
+{
+    QStringList removed;
+    {
+        QMutexLocker locker(&m_indexMutex);
+        for (auto it = m_shapes.begin(); it != m_shapes.end();) {
+            if (it->feature.value("properties").toObject().value("name").toString() == name) {
+                removed.append(it.key());
+                m_changedIds.insert(it.key());
+                it = m_shapes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    if (!removed.isEmpty()) {
+        changed(QHash<QString, QJsonObject>(), removed);
+    }
+    return removed.size();
+}
+
+void ShapeStore::replaceAll(const QJsonObject& collection)
+{
+    {
+        QMutexLocker locker(&m_indexMutex);
+        m_shapes.clear();
+        m_indexStale = true;
+    }
+    const QJsonArray features = collection.value("features").toArray();
+    for (const QJsonValue& value : features) {
+        insertShape(value.toObject());
+    }
+    reset();
+    compact();
+}
+
+QJsonObject ShapeStore::featureCollection() const
+{
+    if (m_cachedRevision != m_revision) {
+        QJsonArray features;
+        for (const Shape& shape : m_shapes) {
+            features.append(shape.feature);
+        }
+
+        m_cachedCollection = QJsonObject();
+        m_cachedCollection["type"] = "FeatureCollection";
+        m_cachedCollection["features"] = features;
+        m_cachedRevision = m_revision;
+    }
+    return m_cachedCollection;
+}
+
+QJsonObject ShapeStore::mergedCollection() const
+{
+    if (m_mergedRevision == m_revision) {
+        return m_mergedCollection;
+    }
+
+    // Zones are grouped by what a merge must not mix, lines and points are
+    // passed through
+    QJsonArray features;
+    QMap<QString, QStringList> groups;
+    for (auto it = m_shapes.constBegin(); it != m_shapes.constEnd(); ++it) {
+        const QString type = it->feature.value("geometry").toObject().value("type").toString();
+        if (type != "Polygon" && type != "MultiPolygon") {
+            features.append(it->feature);
+            continue;
+        }
+
+        const QJsonObject properties = it->feature.value("properties").toObject();
+        const QJsonArray band{properties.value("minAltitude"), properties.value("maxAltitude"),
+                              properties.value("clearance")};
+        groups[QString::fromUtf8(QJsonDocument(band).toJson(QJsonDocument::Compact))].append(it.key());
+    }
+
+    int mergedShapes = 0;
+    for (const QStringList& ids : groups) {
+        QVector<QJsonObject> geometries;
+        geometries.reserve(ids.size());
+        for (const QString& id : ids) {
+            geometries.append(m_shapes.value(id).feature.value("geometry").toObject());
+        }
+
+        QVector<bool> merged(ids.size(), false);
+        for (const PolygonClipper::MergedGroup& group : PolygonClipper::mergeOverlapping(geometries)) {
+            QJsonArray mergedFrom;
+            for (int member : group.members) {
+                merged[member] = true;
+                mergedFrom.append(ids[member]);
+            }
+
+            QJsonObject feature = m_shapes.value(ids[group.members.first()]).feature;
+            QJsonObject properties = feature.value("properties").toObject();
+            properties["mergedFrom"] = mergedFrom;
+            feature["properties"] = properties;
+            feature["geometry"] = group.geometry;
+            features.append(feature);
+            mergedShapes += group.members.size() - 1;
+        }
+        for (int i = 0; i < ids.size(); ++i) {
+            if (!merged[i]) {
+                features.append(m_shapes.value(ids[i]).feature);
+            }
+        }
+    }
+
+    m_mergedCollection = QJsonObject();
+    m_mergedCollection["type"] = "FeatureCollection";
+    m_mergedCollection["features"] = features;
+    m_mergedRevision = m_revision;
+
+    if (mergedShapes > 0) {
+        qDebug() << "Merged overlapping zones," << features.size() << "of" << m_shapes.size() << "shapes remain";
+    }
+    return m_mergedCollection;
+}
+
+template<typename Predicate>
+QStringList ShapeStore::indexedIds(const QVector<int>& values, Predicate overlaps) const
+{
+    // Called with m_indexMutex held; the tree's entries for shapes changed
+    // since it was built are stale, their current boxes are tested instead
+    QStringList ids;
+    ids.reserve(values.size());
+    for (int value : values) {
+        const QString& id = m_indexedIds[value];
+        if (!m_changedIds.contains(id)) {
+            ids.append(id);
+        }
+    }
+    for (const QString& id : m_changedIds) {
+        auto it = m_shapes.constFind(id);
+        if (it != m_shapes.constEnd() && overlaps(it->box)) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+QStringList ShapeStore::queryPoint(double lng, double lat) const
+{
+    QMutexLocker locker(&m_indexMutex);
+    ensureIndex();
+    return indexedIds(m_index.queryPoint(lng, lat), [&](const BoundingBox& box) { return box.contains(lng, lat); });
+}
+
+QStringList ShapeStore::queryBox(const BoundingBox& box) const
+{
+    QMutexLocker locker(&m_indexMutex);
+    ensureIndex();
+    return indexedIds(m_index.queryBox(box), [&](const BoundingBox& other) { return other.intersects(box); });
+}
+
+QStringList ShapeStore::querySegment(double lng1, double lat1, double lng2, double lat2) const
+{
+    QMutexLocker locker(&m_indexMutex);
+    ensureIndex();
+    return indexedIds(m_index.querySegment(lng1, lat1, lng2, lat2), [&](const BoundingBox& box) {
+        return box.intersectsSegment(lng1, lat1, lng2, lat2);
+    });
+}
+
+QStringList ShapeStore::shapesContaining(double lng, double lat) const
+{
+    QMutexLocker locker(&m_indexMutex);
+    ensureIndex();
+
+    QStringList ids;
+    const QStringList candidates = indexedIds(m_index.queryPoint(lng, lat),
+                                              [&](const BoundingBox& box) { return box.contains(lng, lat); });
+    for (const QString& id : candidates) {
+        if (geometryContains(m_shapes.value(id).feature.value("geometry").toObject(), lng, lat)) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+bool ShapeStore::reloadIfChanged()
+{
+    QFileInfo fileInfo(geoJsonPath());
+    if (!fileInfo.exists()) {
+        return false;
+    }
+    if (m_geoJsonModified.isValid() && fileInfo.lastModified() <= m_geoJsonModified) {
+        return false;
+    }
+
+    qDebug() << "Geometric shapes file changed on disk, reloading:" << geoJsonPath();
+
+    QJsonObject collection;
+    if (!readGeoJson(geoJsonPath(), collection)) {
+        return false;
+    }
+    m_geoJsonModified = fileInfo.lastModified();
+
+    // The outside edit replaces the snapshot and whatever the log recorded
+    replaceAll(collection);
+    return true;
+}
+
+void ShapeStore::clear()
+{
+    QFile::remove(snapshotPath());
+    QFile::remove(logPath());
+    QFile::remove(geoJsonPath());
+    m_geoJsonModified = QDateTime();
+    m_logRecords = 0;
+
+    {
+        QMutexLocker locker(&m_indexMutex);
+        m_shapes.clear();
+        m_indexStale = true;
+    }
+    reset();
+}
+
+bool ShapeStore::compact()
+{
+    QVector<QJsonObject> features;
+    QVector<BoundingBox> boxes;
+    features.reserve(m_shapes.size());
+    boxes.reserve(m_shapes.size());
+    for (const Shape& shape : m_shapes) {
+        features.append(shape.feature);
+        boxes.append(shape.box);
+    }
+
+    if (!BinaryGeometryFile::write(snapshotPath(), features, boxes)) {
+        return false;
+    }
+
+    // The snapshot now holds everything the log described
+    QFile log(logPath());
+    if (log.exists() && !log.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to truncate geometric shapes log:" << log.errorString();
+        return false;
+    }
+    log.close();
+    m_logRecords = 0;
+
+    qDebug() << "Compacted geometric shapes snapshot with" << m_shapes.size() << "shapes";
+    return true;
+}
+
+bool ShapeStore::exportGeoJson(const QString& path)
+{
+    const QString target = path.isEmpty() ? geoJsonPath() : path;
+    QSaveFile file(target);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Failed to open geometric shapes file:" << file.errorString();
+        return false;
+    }
+
+    file.write(QJsonDocument(featureCollection()).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        qWarning() << "Failed to write geometric shapes file:" << file.errorString();
+        return false;
+    }
+
+    // Our own export is not an outside edit, and a snapshot written after
+    // it keeps a recovering start reading the binary file
+    if (target == geoJsonPath()) {
+        m_geoJsonModified = QFileInfo(target).lastModified();
+        compact();
+    }
+    return true;
+}
+
+QString ShapeStore::snapshotPath() const
+{
+    return m_directory + "/geometric_shapes.dgb";
+}
+
+QString ShapeStore::logPath() const
+{
+    return m_directory + "/geometric_shapes.log";
+}
+
+QString ShapeStore::geoJsonPath() const
+{
+    return m_directory + "/geometric_shapes.geojson";
+}
+
+QString ShapeStore::insertShape(const QJsonObject& feature, const BoundingBox* box)
+{
+    QJsonObject stored = feature;
+    QString id = feature.value("id").isDouble() ? QString::number(feature.value("id").toDouble())
+                                                : feature.value("id").toString();
+    if (id.isEmpty()) {
+        do {
+            id = QString("%1%2").arg(GENERATED_ID_PREFIX).arg(m_nextId++);
+        } while (m_shapes.contains(id));
+    } else if (id.startsWith(GENERATED_ID_PREFIX)) {
+        // Generated ids stay unique across restarts
+        m_nextId = qMax(m_nextId, id.mid(int(qstrlen(GENERATED_ID_PREFIX))).toULongLong() + 1);
+    }
+
+    // Stored ids are always strings, so subscribers can key shapes by them
+    stored["id"] = id;
+
+    Shape shape;
+    shape.feature = stored;
+    shape.box = box ? *box : BoundingBox::ofGeometry(stored.value("geometry").toObject());
+
+    QMutexLocker locker(&m_indexMutex);
+    m_shapes.insert(id, shape);
+    m_changedIds.insert(id);
+    return id;
+}
+
+void ShapeStore::changed(const QHash<QString, QJsonObject>& upserted, const QStringList& removed)
+{
+    {
+        QMutexLocker locker(&m_indexMutex);
+        m_revision++;
+    }
+
+    // Subscribers only receive the edited shapes
+    UpdateBus::instance().publishShapeChanges(upserted, removed);
+
+    // One log record per edited shape, the snapshot is left alone
+    QList<QJsonObject> records;
+    for (auto it = upserted.constBegin(); it != upserted.constEnd(); ++it) {
+        QJsonObject record;
+        record["op"] = "put";
+        record["id"] = it.key();
+        record["feature"] = it.value();
+        records.append(record);
+    }
+    for (const QString& id : removed) {
+        QJsonObject record;
+        record["op"] = "remove";
+        record["id"] = id;
+        records.append(record);
+    }
+    appendLogRecords(records);
+    compactIfNeeded();
+}
+
+void ShapeStore::reset()
+{
+    {
+        QMutexLocker locker(&m_indexMutex);
+        m_revision++;
+    }
+    UpdateBus::instance().publishShapes(featureCollection());
+}
+
+void ShapeStore::appendLogRecords(const QList<QJsonObject>& records)
+{
+    QFile log(logPath());
+    if (!log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to append to geometric shapes log:" << log.errorString();
+        return;
+    }
+
+    for (const QJsonObject& record : records) {
+        log.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+        log.write("\n");
+        m_logRecords++;
+    }
+    log.close();
+}
+
+void ShapeStore::compactIfNeeded()
+{
+    if (m_logRecords >= qMax(MIN_LOG_RECORDS, m_shapes.size())) {
+        compact();
+    }
+}
+
+bool ShapeStore::loadSnapshot()
+{
+    {
+        QMutexLocker locker(&m_indexMutex);
+        m_shapes.clear();
+        m_indexStale = true;
+    }
+
+    // Only a session that did not exit cleanly leaves a snapshot and log.
+    // A GeoJSON file newer than the snapshot was edited outside the app (or
+    // predates the binary snapshot) and wins over it
+    const QFileInfo geoJson(geoJsonPath());
+    const QFileInfo binary(snapshotPath());
+    const bool fromGeoJson = geoJson.exists() && (!binary.exists() || geoJson.lastModified() > binary.lastModified());
+    m_geoJsonModified = geoJson.exists() ? geoJson.lastModified() : QDateTime();
+
+    if (fromGeoJson) {
+        QJsonObject collection;
+        if (readGeoJson(geoJsonPath(), collection)) {
+            const QJsonArray features = collection.value("features").toArray();
+            for (const QJsonValue& value : features) {
+                insertShape(value.toObject());
+            }
+        }
+        // The log belongs to the binary snapshot the edit replaces
+        if (binary.exists()) {
+            QFile::remove(logPath());
+        }
+    } else {
+        // Boxes come from the offset table, only the features are decoded
+        BinaryGeometryFile snapshot;
+        if (snapshot.open(snapshotPath())) {
+            for (int i = 0; i < snapshot.count(); ++i) {
+                const BoundingBox box = snapshot.featureBounds(i);
+                insertShape(snapshot.feature(i), box.isNull() ? nullptr : &box);
+            }
+        } else if (binary.exists()) {
+            qWarning() << "Invalid geometric shapes snapshot:" << snapshotPath() << "-" << snapshot.errorString();
+        }
+    }
+
+    // Replay edits recorded after the snapshot
+    m_logRecords = 0;
+    QFile log(logPath());
+    if (log.open(QIODevice::ReadOnly)) {
+        while (!log.atEnd()) {
+            QByteArray line = log.readLine().trimmed();
+            if (line.isEmpty()) {
+                continue;
+            }
+
+            QJsonObject record = QJsonDocument::fromJson(line).object();
+            if (record.value("op").toString() == "put") {
+                insertShape(record.value("feature").toObject());
+            } else if (record.value("op").toString() == "remove") {
+                QMutexLocker locker(&m_indexMutex);
+                m_shapes.remove(record.value("id").toString());
+                m_changedIds.insert(record.value("id").toString());
+            }
+            m_logRecords++;
+        }
+        log.close();
+    }
+
+    reset();
+    qDebug() << "Loaded" << m_shapes.size() << "geometric shapes," << m_logRecords << "log records";
+
+    // Keep the binary snapshot current after reading GeoJSON
+    if (fromGeoJson) {
+        compact();
+    }
+    return true;
+}
+
+void ShapeStore::ensureIndex() const
+{
+    // Called with m_indexMutex held. A few edits are tested next to the
+    // tree by indexedIds(), it is only rebuilt after a batch of them.
+    const int rebuildAfter = qMax(MIN_INDEX_CHANGES, m_indexedIds.size() / INDEX_CHANGES_DIVISOR);
+    if (!m_indexStale && m_changedIds.size() <= rebuildAfter) {
+        return;
+    }
+
+    QVector<SpatialIndex::Entry> entries;
+    entries.reserve(m_shapes.size());
+    m_indexedIds.clear();
+    m_indexedIds.reserve(m_shapes.size());
+    for (auto it = m_shapes.constBegin(); it != m_shapes.constEnd(); ++it) {
+        SpatialIndex::Entry entry;
+        entry.box = it->box;
+        entry.value = m_indexedIds.size();
+        entries.append(entry);
+        m_indexedIds.append(it.key());
+    }
+
+    m_index.build(entries);
+    m_changedIds.clear();
+    m_indexStale = false;
+}
@@ -0,0 +1,237 @@
+#include "../../include/map/spatialindex.h"
+#include <QtMath>
+#include <algorithm>
+
+const int SpatialIndex::NODE_CAPACITY;
+
+namespace {
+void expandWithPositions(BoundingBox& box, const QJsonArray& coordinates)
+{
+    // A position is an array of numbers, anything else nests further
+    if (!coordinates.isEmpty() && coordinates[0].isDouble()) {
+        if (coordinates.size() >= 2) {
+            box.expand(coordinates[0].toDouble(), coordinates[1].toDouble());
+        }
+        return;
+    }
+    for (const QJsonValue& child : coordinates) {
+        expandWithPositions(box, child.toArray());
+    }
+}
+
+// Sorts items by the center of their box and groups them into nodes of at
+// most NODE_CAPACITY, tiling first by x then by y
+template<typename Item, typename BoxOf>
+void sortTileRecursive(QVector<Item>& items, BoxOf boxOf)
+{
+    const int capacity = SpatialIndex::NODE_CAPACITY;
+    const int nodeCount = (items.size() + capacity - 1) / capacity;
+    const int sliceCount = qMax(1, int(std::ceil(std::sqrt(double(nodeCount)))));
+    const int sliceSize = sliceCount * capacity;
+
+    std::sort(items.begin(), items.end(), [&boxOf](const Item& a, const Item& b) {
+        return boxOf(a).centerX() < boxOf(b).centerX();
+    });
+    for (int start = 0; start < items.size(); start += sliceSize) {
+        auto sliceEnd = items.begin() + qMin(items.size(), start + sliceSize);
+        std::sort(items.begin() + start, sliceEnd, [&boxOf](const Item& a, const Item& b) {
+            return boxOf(a).centerY() < boxOf(b).centerY();
+        });
+    }
+}
+}
+
+void BoundingBox::expand(double x, double y)
+{
+    minX = qMin(minX, x);
+    minY = qMin(minY, y);
+    maxX = qMax(maxX, x);
+    maxY = qMax(maxY, y);
+}
+
+void BoundingBox::expand(const BoundingBox& other)
+{
+    if (other.isNull()) {
+        return;
+    }
+    minX = qMin(minX, other.minX);
+    minY = qMin(minY, other.minY);
+    maxX = qMax(maxX, other.maxX);
+    maxY = qMax(maxY, other.maxY);
+}
+
+bool BoundingBox::intersects(const BoundingBox& other) const
+{
+    return !isNull() && !other.isNull() &&
+           minX <= other.maxX && other.minX <= maxX &&
+           minY <= other.maxY && other.minY <= maxY;
+}
+
+bool BoundingBox::contains(double x, double y) const
+{
+    return x >= minX && x <= maxX && y >= minY && y <= maxY;
+}
+
+bool BoundingBox::intersectsSegment(double x1, double y1, double x2, double y2) const
+{
+    if (isNull()) {
+        return false;
+    }
+
+    // Liang-Barsky clipping of the segment against the box
+    double t0 = 0.0;
+    double t1 = 1.0;
+    const double dx = x2 - x1;
+    const double dy = y2 - y1;
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] = { x1 - minX, maxX - x1, y1 - minY, maxY - y1 };
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0.0) {
+            if (q[i] < 0.0) {
+                return false;
+            }
+            continue;
+        }
+        const double t = q[i] / p[i];
+        if (p[i] < 0.0) {
+            t0 = qMax(t0, t);
+        } else {
+            t1 = qMin(t1, t);
+        }
+        if (t0 > t1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BoundingBox BoundingBox::ofGeometry(const QJsonObject& geometry)
+{
+    BoundingBox box;
+    if (geometry.value("type").toString() == "GeometryCollection") {
+        for (const QJsonValue& child : geometry.value("geometries").toArray()) {
+            box.expand(ofGeometry(child.toObject()));
+        }
+    } else {
+        expandWithPositions(box, geometry.value("coordinates").toArray());
+    }
+    return box;
+}
+
+SpatialIndex::SpatialIndex()
+    : m_root(-1)
+{
+}
+
+void SpatialIndex::build(QVector<Entry> entries)
+{
+    m_entries.clear();
+    m_nodes.clear();
+    m_root = -1;
+
+    // Entries without a box can never match a query
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& entry) {
+        return entry.box.isNull();
+    }), entries.end());
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    // Leaves over the packed entries
+    sortTileRecursive(entries, [](const Entry& entry) -> const BoundingBox& { return entry.box; });
+    m_entries = entries;
+
+    QVector<Node> level;
+    for (int first = 0; first < m_entries.size(); first += NODE_CAPACITY) {
+        Node leaf;
+        leaf.first = first;
+        leaf.count = qMin(NODE_CAPACITY, m_entries.size() - first);
+        leaf.leaf = true;
+        for (int i = first; i < first + leaf.count; ++i) {
+            leaf.box.expand(m_entries[i].box);
+        }
+        level.append(leaf);
+    }
+
+    // Pack every level into the next until a single root remains
+    while (true) {
+        sortTileRecursive(level, [](const Node& node) -> const BoundingBox& { return node.box; });
+        const int levelStart = m_nodes.size();
+        m_nodes += level;
+        if (level.size() == 1) {
+            m_root = levelStart;
+            break;
+        }
+
+        QVector<Node> parents;
+        for (int first = 0; first < level.size(); first += NODE_CAPACITY) {
+            Node parent;
+            parent.first = levelStart + first;
+            parent.count = qMin(NODE_CAPACITY, level.size() - first);
+            parent.leaf = false;
+            for (int i = first; i < first + parent.count; ++i) {
+                parent.box.expand(level[i].box);
+            }
+            parents.append(parent);
+        }
+        level = parents;
+    }
+}
+
+void SpatialIndex::clear()
+{
+    m_entries.clear();
+    m_nodes.clear();
+    m_root = -1;
+}
+
+BoundingBox SpatialIndex::bounds() const
+{
+    return m_root >= 0 ? m_nodes[m_root].box : BoundingBox();
+}
+
+QVector<int> SpatialIndex::queryPoint(double x, double y) const
+{
+    return query([x, y](const BoundingBox& box) { return box.contains(x, y); });
+}
+
+QVector<int> SpatialIndex::queryBox(const BoundingBox& box) const
+{
+    return query([&box](const BoundingBox& other) { return other.intersects(box); });
+}
+
+QVector<int> SpatialIndex::querySegment(double x1, double y1, double x2, double y2) const
+{
+    return query([x1, y1, x2, y2](const BoundingBox& box) { return box.intersectsSegment(x1, y1, x2, y2); });
+}
+
+template<typename Predicate>
+QVector<int> SpatialIndex::query(Predicate overlaps) const
+{
+    QVector<int> values;
+    if (m_root < 0) {
+        return values;
+    }
+
+    QVector<int> stack;
+    stack.append(m_root);
+    while (!stack.isEmpty()) {
+        const Node& node = m_nodes[stack.takeLast()];
+        if (!overlaps(node.box)) {
+            continue;
+        }
+
+        if (node.leaf) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                if (overlaps(m_entries[i].box)) {
+                    values.append(m_entries[i].value);
+                }
+            }
+        } else {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                stack.append(i);
+            }
+        }
+    }
+    return values;
+}
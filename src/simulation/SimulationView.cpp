@@ -1,4 +1,6 @@
 #include "../../include/simulation/SimulationView.h"
+#include "../../include/drone/UpdateBus.h"
+#include "../../include/map/jsdispatcher.h"
 #include <QVector3D>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -12,7 +14,7 @@ SimulationView::SimulationView(QWidget* parent) : QWidget(parent)
 {
     setupUI();
     createSimulationHtml();
-    startPathUpdateTimer();
+    subscribeToUpdates();
 }
 
 void SimulationView::setupUI()
@@ -27,49 +29,58 @@ void SimulationView::setupUI()
 void SimulationView::loadSimulation()
 {
     webView->setHtml(simulationHtml, QUrl("qrc:/"));
-    updateDronePath("Atlas"); // Initial path load
+
+    // Initial path load, the newer of the planned path and the command trail
+    UpdateBus& bus = UpdateBus::instance();
+    PathSnapshotPtr path = bus.latestPath("Atlas");
+    PathSnapshotPtr trail = bus.latestCommandTrail("Atlas");
+    if (!path || (trail && trail->revision > path->revision)) {
+        path = trail;
+    }
+    if (!path) {
+        qDebug() << "No path published yet for drone: Atlas";
+        return;
+    }
+    updateDronePath(path);
 }
 
-void SimulationView::startPathUpdateTimer()
+void SimulationView::subscribeToUpdates()
 {
-    // Create update timer for path
-    QTimer* timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, [this]() {
-        updateDronePath("Atlas");
+    // Paths and positions arrive in-process, no file is read
+    UpdateBus& bus = UpdateBus::instance();
+    auto showAtlas = [this](PathSnapshotPtr snapshot) {
+        if (snapshot->droneName == "Atlas" && !snapshot->feature.isEmpty()) {
+            updateDronePath(snapshot);
+        }
+    };
+    connect(&bus, &UpdateBus::pathPublished, this, showAtlas);
+    connect(&bus, &UpdateBus::commandTrailPublished, this, showAtlas);
+    connect(&bus, &UpdateBus::positionsPublished, this, [this](PositionsSnapshotPtr snapshot) {
+        setDronePositions(snapshot->positions);
     });
-    timer->start(1000); // Update every second
 }
 
-void SimulationView::updateDronePath(const QString& droneName)
+void SimulationView::updateDronePath(PathSnapshotPtr snapshot)
 {
-    // Get the absolute path to the build directory
-    QDir buildDir(QCoreApplication::applicationDirPath());
-    buildDir.cdUp(); // Move up from the executable location to build directory
+    const QString droneName = snapshot->droneName;
     
-    // Construct the full path to the GeoJSON file
-    QString filename = buildDir.absoluteFilePath(QString("drone_geojson/%1_path.geojson").arg(droneName));
-    QFile file(filename);
+    // Tag the path as the animation track of this drone
+    QJsonObject feature = snapshot->feature;
+    QJsonObject properties = feature["properties"].toObject();
+    properties["featureType"] = "animation";
+    properties["droneName"] = droneName;
+    feature["properties"] = properties;
     
-    qDebug() << "Trying to open file:" << filename;
+    QJsonObject collection;
+    collection["type"] = "FeatureCollection";
+    collection["features"] = QJsonArray{feature};
     
-    if (file.open(QIODevice::ReadOnly)) {
-        QByteArray data = file.readAll();
-        file.close();
-        
-        // Convert to string and escape properly for JS
-        QString jsonString = QString::fromUtf8(data).replace("\\", "\\\\").replace("'", "\\'").replace("\n", "\\n");
-        
-        // Update path in JavaScript
-        QString script = QString("updateDronePathFromData('%1');").arg(jsonString);
-        webView->page()->runJavaScript(script);
-        
-        // Log success
-        qDebug() << "Successfully loaded and updated path for drone:" << droneName;
-    } else {
-        qDebug() << "Failed to open file:" << filename;
-        qDebug() << "Current working directory:" << QDir::currentPath();
-        qDebug() << "Application directory:" << QCoreApplication::applicationDirPath();
-    }
+    // Pass the data as an object literal, no string escaping or JSON.parse needed
+    QString jsonString = QJsonDocument(collection).toJson(QJsonDocument::Compact);
+    QString script = QString("updateDronePathFromData(%1);").arg(jsonString);
+    JsDispatcher::forView(webView)->call("updateDronePath:" + droneName, script);
+    
+    qDebug() << "Successfully updated path for drone:" << droneName;
 }
 
 void SimulationView::setDronePositions(const QVector<QVector3D>& positions)
@@ -88,7 +99,7 @@ void SimulationView::setDronePositions(const QVector<QVector3D>& positions)
     QString jsonString = doc.toJson(QJsonDocument::Compact);
     
     QString script = QString("updateDronePositions(%1);").arg(jsonString);
-    webView->page()->runJavaScript(script);
+    JsDispatcher::forView(webView)->call("updateDronePositions", script);
 }
 
 void SimulationView::createSimulationHtml()
@@ -374,10 +385,9 @@ void SimulationView::createSimulationHtml()
         const dronePaths = {};
         
         // Function to update drone path from data
-        function updateDronePathFromData(jsonString) {
+        function updateDronePathFromData(pathData) {
             try {
-                console.log('Received path data:', jsonString);
-                const data = JSON.parse(jsonString);
+                const data = typeof pathData === 'string' ? JSON.parse(pathData) : pathData;
                 
                 data.features.forEach(feature => {
                     if (feature.properties.featureType === 'animation') {
@@ -390,7 +400,7 @@ void SimulationView::createSimulationHtml()
                         // Create path geometry with thicker line
                         const points = coordinates.map(coord => {
                             // Scale up the height for better visibility
-                            return new THREE.Vector3(coord[0], coord[2], coord[1]);
+                            return new THREE.Vector3(coord[0], coord[2] || 0, coord[1]);
                         });
                         
                         if (dronePaths[droneName]) {
@@ -430,7 +440,7 @@ void SimulationView::createSimulationHtml()
                 });
             } catch (error) {
                 console.error('Error updating drone path:', error);
-                console.error('JSON string was:', jsonString);
+                console.error('Path data was:', pathData);
             }
         }
         
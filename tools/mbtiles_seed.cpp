@@ -0,0 +1,249 @@
+// Pre-seeds the offline MBTiles store used by MbtilesSchemeHandler with the
+// vector tiles of a region, so the map works without connectivity.
+//
+//   mbtiles_seed --bbox 77.90,10.30,78.05,10.42 --minzoom 0 --maxzoom 15 \
+//       --token <mapbox token> --output tiles/offline.mbtiles
+//
+// Tiles already in the store are skipped, so an interrupted seed can resume.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFileInfo>
+#include <QDir>
+#include <QQueue>
+#include <QTimer>
+#include <QUrl>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const int MAX_CONCURRENT_REQUESTS = 6;
+const int COMMIT_EVERY_TILES = 500;
+const char* DEFAULT_TILE_URL =
+    "https://api.mapbox.com/v4/mapbox.mapbox-streets-v8/{z}/{x}/{y}.vector.pbf?access_token={token}";
+
+struct TileId {
+    int z;
+    int x;
+    int y;
+};
+
+int lonToTileX(double lon, int z)
+{
+    return qBound(0, int(std::floor((lon + 180.0) / 360.0 * (1 << z))), (1 << z) - 1);
+}
+
+int latToTileY(double lat, int z)
+{
+    double latRad = qDegreesToRadians(qBound(-85.0511, lat, 85.0511));
+    double y = (1.0 - std::log(std::tan(latRad) + 1.0 / std::cos(latRad)) / M_PI) / 2.0 * (1 << z);
+    return qBound(0, int(std::floor(y)), (1 << z) - 1);
+}
+}
+
+class TileSeeder : public QObject
+{
+    Q_OBJECT
+public:
+    TileSeeder(const QString& urlTemplate, QSqlDatabase database, const QQueue<TileId>& tiles, QObject* parent = nullptr)
+        : QObject(parent)
+        , m_urlTemplate(urlTemplate)
+        , m_database(database)
+        , m_pending(tiles)
+        , m_total(tiles.size())
+        , m_done(0)
+        , m_failed(0)
+        , m_active(0)
+    {
+        m_insert = QSqlQuery(m_database);
+        m_insert.prepare("INSERT OR REPLACE INTO tiles (zoom_level, tile_column, tile_row, tile_data) VALUES (?, ?, ?, ?)");
+    }
+
+    void start()
+    {
+        m_database.transaction();
+        fillRequests();
+        finishIfDone();
+    }
+
+signals:
+    void finished(int failedTiles);
+
+private:
+    void fillRequests()
+    {
+        while (m_active < MAX_CONCURRENT_REQUESTS && !m_pending.isEmpty()) {
+            TileId tile = m_pending.dequeue();
+            QString url = m_urlTemplate;
+            url.replace("{z}", QString::number(tile.z))
+               .replace("{x}", QString::number(tile.x))
+               .replace("{y}", QString::number(tile.y));
+
+            QNetworkReply* reply = m_network.get(QNetworkRequest(QUrl(url)));
+            m_active++;
+            connect(reply, &QNetworkReply::finished, this, [this, reply, tile]() {
+                handleReply(reply, tile);
+            });
+        }
+    }
+
+    void handleReply(QNetworkReply* reply, const TileId& tile)
+    {
+        m_active--;
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+        // 404 means the tile is empty at the source, store it as such
+        if (reply->error() == QNetworkReply::NoError || status == 404) {
+            QByteArray data = status == 404 ? QByteArray("") : reply->readAll();
+            m_insert.bindValue(0, tile.z);
+            m_insert.bindValue(1, tile.x);
+            m_insert.bindValue(2, (1 << tile.z) - 1 - tile.y);
+            m_insert.bindValue(3, data);
+            if (!m_insert.exec()) {
+                qWarning() << "Error storing tile:" << m_insert.lastError().text();
+                m_failed++;
+            }
+        } else {
+            qWarning() << "Error fetching tile" << tile.z << tile.x << tile.y << "-" << reply->errorString();
+            m_failed++;
+        }
+        reply->deleteLater();
+
+        m_done++;
+        if (m_done % COMMIT_EVERY_TILES == 0) {
+            m_database.commit();
+            m_database.transaction();
+            qInfo().noquote() << QString("%1/%2 tiles").arg(m_done).arg(m_total);
+        }
+
+        fillRequests();
+        finishIfDone();
+    }
+
+    void finishIfDone()
+    {
+        if (m_active == 0 && m_pending.isEmpty()) {
+            m_database.commit();
+            qInfo().noquote() << QString("Seeded %1 tiles, %2 failed").arg(m_done - m_failed).arg(m_failed);
+            emit finished(m_failed);
+        }
+    }
+
+    QString m_urlTemplate;
+    QSqlDatabase m_database;
+    QSqlQuery m_insert;
+    QNetworkAccessManager m_network;
+    QQueue<TileId> m_pending;
+    int m_total;
+    int m_done;
+    int m_failed;
+    int m_active;
+};
+
+static bool createSchema(QSqlDatabase& database)
+{
+    QSqlQuery query(database);
+    return query.exec("CREATE TABLE IF NOT EXISTS metadata (name TEXT PRIMARY KEY, value TEXT)") &&
+           query.exec("CREATE TABLE IF NOT EXISTS tiles (zoom_level INTEGER, tile_column INTEGER, "
+                      "tile_row INTEGER, tile_data BLOB)") &&
+           query.exec("CREATE UNIQUE INDEX IF NOT EXISTS tile_index ON tiles (zoom_level, tile_column, tile_row)");
+}
+
+static void writeMetadata(QSqlDatabase& database, const QList<QPair<QString, QString>>& values)
+{
+    QSqlQuery query(database);
+    query.prepare("INSERT OR REPLACE INTO metadata (name, value) VALUES (?, ?)");
+    for (const auto& value : values) {
+        query.bindValue(0, value.first);
+        query.bindValue(1, value.second);
+        query.exec();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("mbtiles_seed");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Pre-seed the offline map tile store for a region");
+    parser.addHelpOption();
+    parser.addOption({"bbox", "Region as minLon,minLat,maxLon,maxLat.", "bbox"});
+    parser.addOption({"minzoom", "Lowest zoom level to seed.", "zoom", "0"});
+    parser.addOption({"maxzoom", "Highest zoom level to seed.", "zoom", "15"});
+    parser.addOption({"url", "Tile URL template with {z}, {x}, {y} and {token}.", "url", DEFAULT_TILE_URL});
+    parser.addOption({"token", "Access token substituted for {token}.", "token"});
+    parser.addOption({"output", "MBTiles file to create or extend.", "file", "tiles/offline.mbtiles"});
+    parser.process(app);
+
+    const QStringList bbox = parser.value("bbox").split(',');
+    if (bbox.size() != 4) {
+        qCritical() << "--bbox must be minLon,minLat,maxLon,maxLat";
+        return 1;
+    }
+    const double minLon = bbox[0].toDouble();
+    const double minLat = bbox[1].toDouble();
+    const double maxLon = bbox[2].toDouble();
+    const double maxLat = bbox[3].toDouble();
+    const int minZoom = qBound(0, parser.value("minzoom").toInt(), 22);
+    const int maxZoom = qBound(minZoom, parser.value("maxzoom").toInt(), 22);
+
+    QString urlTemplate = parser.value("url");
+    urlTemplate.replace("{token}", parser.value("token"));
+
+    const QString output = parser.value("output");
+    QDir().mkpath(QFileInfo(output).absolutePath());
+
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE");
+    database.setDatabaseName(output);
+    if (!database.open() || !createSchema(database)) {
+        qCritical() << "Error opening tile store:" << database.lastError().text();
+        return 1;
+    }
+
+    writeMetadata(database, {
+        {"name", "Offline region"},
+        {"format", "pbf"},
+        {"type", "baselayer"},
+        {"minzoom", QString::number(minZoom)},
+        {"maxzoom", QString::number(maxZoom)},
+        {"bounds", QString("%1,%2,%3,%4").arg(minLon).arg(minLat).arg(maxLon).arg(maxLat)},
+        {"center", QString("%1,%2,%3").arg((minLon + maxLon) / 2).arg((minLat + maxLat) / 2).arg(maxZoom)}
+    });
+
+    // Every tile of the region at every zoom, minus those already stored
+    QQueue<TileId> tiles;
+    QSqlQuery existing(database);
+    existing.prepare("SELECT 1 FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?");
+    for (int z = minZoom; z <= maxZoom; ++z) {
+        for (int x = lonToTileX(minLon, z); x <= lonToTileX(maxLon, z); ++x) {
+            for (int y = latToTileY(maxLat, z); y <= latToTileY(minLat, z); ++y) {
+                existing.bindValue(0, z);
+                existing.bindValue(1, x);
+                existing.bindValue(2, (1 << z) - 1 - y);
+                if (existing.exec() && existing.next()) {
+                    continue;
+                }
+                tiles.enqueue({z, x, y});
+            }
+        }
+    }
+    existing.finish();
+    qInfo().noquote() << QString("Seeding %1 tiles into %2").arg(tiles.size()).arg(output);
+
+    TileSeeder seeder(urlTemplate, database, tiles);
+    QObject::connect(&seeder, &TileSeeder::finished, &app, [&app](int failedTiles) {
+        app.exit(failedTiles == 0 ? 0 : 2);
+    });
+    QTimer::singleShot(0, &seeder, [&seeder]() { seeder.start(); });
+
+    return app.exec();
+}
+
+#include "mbtiles_seed.moc"